@@ -26,6 +26,9 @@ export MMTK_PLAN=GenImmix
 
 run_subset 4
 
+# GC threads stop the world themselves, so nobody holds Heap_lock across the pause
+MMTK_DIRECT_STW=1 run_subset 4
+
 # --- StickyImmix ---
 export MMTK_PLAN=StickyImmix
 
@@ -73,6 +73,15 @@ export MMTK_PLAN=MarkSweep
 
 run_all_no_compressed_oop 4
 
+# --- ConcurrentImmix ---
+export MMTK_PLAN=ConcurrentImmix
+
+# Flush the mutators through handshakes while marking concurrently
+MMTK_FLUSH_MUTATORS_INTERVAL_MS=1 runbms_dacapo2006_with_heap_multiplier fop 4 -XX:-UseCompressedOops -XX:-UseCompressedClassPointers
+MMTK_FLUSH_MUTATORS_INTERVAL_MS=1 runbms_dacapo2006_with_heap_multiplier lusearch 4 -XX:-UseCompressedOops -XX:-UseCompressedClassPointers
+# The companion thread only flushes the mutators if the GC threads stop the world themselves
+MMTK_FLUSH_MUTATORS_INTERVAL_MS=1 MMTK_DIRECT_STW=1 runbms_dacapo2006_with_heap_multiplier lusearch 4 -XX:-UseCompressedOops -XX:-UseCompressedClassPointers
+
 # --- PageProtect ---
 # Make sure this runs last in our tests unless we want to set it back to the default limit.
 sudo sysctl -w vm.max_map_count=655300
@@ -66,3 +66,20 @@ run_all 4
 export MMTK_PLAN=MarkSweep
 
 run_all 8
+
+# --- Binding options ---
+export MMTK_PLAN=GenImmix
+
+# Let the GC threads stop the world themselves instead of going through the companion thread
+MMTK_DIRECT_STW=1 run_all 4
+
+# Run finalizers on several threads
+MMTK_FINALIZER_THREADS=4 runbms_dacapo2006_with_heap_multiplier eclipse 4
+MMTK_FINALIZER_THREADS=4 runbms_dacapo2006_with_heap_multiplier fop 4
+
+# Sample allocation events for a JFR recording at a fixed byte interval
+MMTK_ALLOCATION_SAMPLE_BYTES=65536 runbms_dacapo2006_with_heap_multiplier fop 4 -XX:StartFlightRecording=settings=profile,filename=/tmp/mmtk-fop.jfr
+
+# Keep a reserve for allocations that happen while GC is not allowed
+MMTK_ALLOCATION_RESERVE_BYTES=1048576 runbms_dacapo2006_with_heap_multiplier lusearch 2
+MMTK_ALLOCATION_RESERVE_BYTES=1048576 runbms_dacapo2006_with_heap_multiplier pmd 2
@@ -13,6 +13,28 @@ run_subset() {
     runbms_dacapo2006_with_heap_multiplier luindex $heap_multiplier $jvm_options
 }
 
+# jmap -histo walks the heap with object_iterate, which relies on the VO bit.
+run_jmap_histo() {
+    benchmark=$1
+
+    $TEST_JAVA_BIN -XX:+UseThirdPartyHeap -server -XX:MetaspaceSize=100M -Xms500M -Xmx500M -jar $DACAPO_PATH/dacapo-2006-10-MR2.jar -n 10 $benchmark &
+    java_pid=$!
+
+    # Retry until the VM accepts the attach request.
+    histo=
+    for attempt in $(seq 30); do
+        sleep 1
+        if histo=$($(dirname $TEST_JAVA_BIN)/jmap -histo $java_pid); then
+            break
+        fi
+    done
+    wait $java_pid
+
+    # A broken heap walk still prints the header, so check that it found objects.
+    echo "$histo" | grep -q " java.lang.String "
+    echo "$histo" | awk '$1 == "Total" && $2 > 0 { found = 1 } END { exit !found }'
+}
+
 # --- SemiSpace ---
 export MMTK_PLAN=SemiSpace
 
@@ -22,6 +44,7 @@ run_subset 4
 export MMTK_PLAN=Immix
 
 run_subset 4
+run_jmap_histo eclipse
 
 # --- GenImmix ---
 export MMTK_PLAN=GenImmix
@@ -278,6 +278,20 @@ impl InstanceRefKlass {
         }
         *DISCOVERED_OFFSET
     }
+    fn soft_reference_timestamp_offset() -> i32 {
+        lazy_static! {
+            pub static ref SOFT_REFERENCE_TIMESTAMP_OFFSET: i32 =
+                unsafe { ((*UPCALLS).soft_reference_timestamp_offset)() };
+        }
+        *SOFT_REFERENCE_TIMESTAMP_OFFSET
+    }
+    /// The value of `SoftReference.timestamp` of a `SoftReference` instance.
+    pub fn soft_reference_timestamp(oop: Oop) -> i64 {
+        unsafe {
+            oop.get_field_address(Self::soft_reference_timestamp_offset())
+                .load::<i64>()
+        }
+    }
     pub fn referent_address<const COMPRESSED: bool>(oop: Oop) -> OpenJDKSlot<COMPRESSED> {
         oop.get_field_address(Self::referent_offset()).into()
     }
@@ -350,12 +364,6 @@ pub type Oop = &'static OopDesc;
 #[derive(Clone, Copy)]
 pub struct NarrowOop(u32);
 
-impl NarrowOop {
-    pub fn slot(&self) -> Address {
-        Address::from_ref(self)
-    }
-}
-
 /// Convert ObjectReference to Oop
 impl From<ObjectReference> for &OopDesc {
     fn from(o: ObjectReference) -> Self {
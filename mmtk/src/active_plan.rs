@@ -4,35 +4,25 @@ use crate::UPCALLS;
 use mmtk::util::opaque_pointer::*;
 use mmtk::vm::ActivePlan;
 use mmtk::Mutator;
-use std::collections::VecDeque;
-use std::marker::PhantomData;
 
-struct OpenJDKMutatorIterator<'a, const COMPRESSED: bool> {
-    mutators: VecDeque<&'a mut Mutator<OpenJDK<COMPRESSED>>>,
-    phantom_data: PhantomData<&'a ()>,
-}
-
-impl<const COMPRESSED: bool> OpenJDKMutatorIterator<'_, COMPRESSED> {
-    fn new() -> Self {
-        let mut mutators = VecDeque::new();
-        unsafe {
-            ((*UPCALLS).get_mutators)(MutatorClosure::from_rust_closure(&mut |mutator| {
-                mutators.push_back(mutator);
-            }));
-        }
-        Self {
-            mutators,
-            phantom_data: PhantomData,
-        }
+/// The mutators of all Java threads, as recorded by the C++ side when the mutators were stopped.
+///
+/// The snapshot is only valid while the mutators are stopped.  It is taken once per pause and
+/// shared by stopping the mutators, root scanning, and preparing and releasing the mutators.
+/// Returns `None` outside a pause.
+pub(crate) fn mutators_snapshot<const COMPRESSED: bool>(
+) -> Option<&'static [*mut Mutator<OpenJDK<COMPRESSED>>]> {
+    let mut len = 0;
+    let mutators = unsafe { ((*UPCALLS).get_mutators)(&mut len) };
+    if mutators.is_null() {
+        return None;
     }
-}
-
-impl<'a, const COMPRESSED: bool> Iterator for OpenJDKMutatorIterator<'a, COMPRESSED> {
-    type Item = &'a mut Mutator<OpenJDK<COMPRESSED>>;
-
-    fn next(&mut self) -> Option<Self::Item> {
-        self.mutators.pop_front()
+    if len == 0 {
+        return Some(&[]);
     }
+    Some(unsafe {
+        std::slice::from_raw_parts(mutators as *const *mut Mutator<OpenJDK<COMPRESSED>>, len)
+    })
 }
 
 pub struct VMActivePlan {}
@@ -50,7 +40,17 @@ impl<const COMPRESSED: bool> ActivePlan<OpenJDK<COMPRESSED>> for VMActivePlan {
     }
 
     fn mutators<'a>() -> Box<dyn Iterator<Item = &'a mut Mutator<OpenJDK<COMPRESSED>>> + 'a> {
-        Box::new(OpenJDKMutatorIterator::<COMPRESSED>::new())
+        if let Some(snapshot) = mutators_snapshot::<COMPRESSED>() {
+            return Box::new(snapshot.iter().map(|mutator| unsafe { &mut **mutator }));
+        }
+        // Outside a pause, the snapshot may refer to threads that have exited since.
+        let mut mutators: Vec<&'a mut Mutator<OpenJDK<COMPRESSED>>> = Vec::new();
+        unsafe {
+            ((*UPCALLS).get_live_mutators)(MutatorClosure::from_rust_closure::<_, COMPRESSED>(
+                &mut |mutator| mutators.push(mutator),
+            ));
+        }
+        Box::new(mutators.into_iter())
     }
 
     fn number_of_mutators() -> usize {
@@ -0,0 +1,92 @@
+//! A per-mutator allocation reserve that lets mutators keep allocating while a GC is pending.
+//!
+//! Normally a mutator whose allocation triggers a GC blocks in `block_for_gc` until the GC has
+//! finished, even though the GC cannot start before every other mutator has reached a safepoint.
+//! With a reserve, a mutator whose allocation fails because a GC is pending over-commits the heap
+//! instead, and keeps running until it is stopped at the safepoint.  Only a mutator that has
+//! over-committed more than the reserve since the last GC blocks in the allocation slow path.
+//!
+//! The reserve is charged for the heap memory an over-committed allocation acquires, not just for
+//! the object, because the slow path may hand the mutator a whole block or bump region that the
+//! fast path then fills without coming back here.  A mutator may therefore overshoot its reserve
+//! by at most one such region.
+
+use mmtk::memory_manager;
+use mmtk::util::alloc::AllocationOptions;
+use mmtk::util::Address;
+use mmtk::AllocationSemantics;
+use mmtk::Mutator;
+use std::cell::Cell;
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+use crate::OpenJDK;
+
+/// The bytes each mutator may over-commit between two GCs.  0 disables the reserve.
+static RESERVE_BYTES: AtomicUsize = AtomicUsize::new(0);
+/// Incremented every time the mutators are resumed, which resets all reserves.
+static EPOCH: AtomicUsize = AtomicUsize::new(0);
+
+thread_local! {
+    /// The epoch in which this mutator last used its reserve, and the bytes used in that epoch.
+    static RESERVE_USED: Cell<(usize, usize)> = const { Cell::new((0, 0)) };
+}
+
+pub fn set_reserve_bytes(bytes: usize) {
+    RESERVE_BYTES.store(bytes, Ordering::Relaxed);
+}
+
+/// Called before the mutators are resumed after a GC.
+pub fn on_mutators_resumed() {
+    EPOCH.fetch_add(1, Ordering::Relaxed);
+}
+
+/// Allocate like `memory_manager::alloc`, but use the reserve instead of blocking for GC while it
+/// lasts.
+pub fn alloc<const COMPRESSED: bool>(
+    mutator: &mut Mutator<OpenJDK<COMPRESSED>>,
+    size: usize,
+    align: usize,
+    offset: usize,
+    semantics: AllocationSemantics,
+) -> Address {
+    let reserve = RESERVE_BYTES.load(Ordering::Relaxed);
+    if reserve == 0 {
+        return memory_manager::alloc(mutator, size, align, offset, semantics);
+    }
+
+    let epoch = EPOCH.load(Ordering::Relaxed);
+    let (used_epoch, used) = RESERVE_USED.get();
+    let used = if used_epoch == epoch { used } else { 0 };
+    if used + size > reserve {
+        return memory_manager::alloc(mutator, size, align, offset, semantics);
+    }
+
+    // Try without blocking first.  This fails (and requests a GC) only if the heap is full.
+    let no_block = AllocationOptions {
+        allow_overcommit: false,
+        at_safepoint: false,
+    };
+    let result =
+        memory_manager::alloc_with_options(mutator, size, align, offset, semantics, no_block);
+    if !result.is_zero() {
+        return result;
+    }
+
+    let overcommit = AllocationOptions {
+        allow_overcommit: true,
+        at_safepoint: false,
+    };
+    let mmtk = crate::singleton::<COMPRESSED>();
+    let used_before = memory_manager::used_bytes(mmtk);
+    let result =
+        memory_manager::alloc_with_options(mutator, size, align, offset, semantics, overcommit);
+    if result.is_zero() {
+        // Out of memory, even when over-committing.  Let the normal path block and report it.
+        return memory_manager::alloc(mutator, size, align, offset, semantics);
+    }
+    // Charge however much the heap grew.  This may include memory acquired concurrently by other
+    // mutators, which only makes this reserve run out sooner.
+    let acquired = memory_manager::used_bytes(mmtk).saturating_sub(used_before);
+    RESERVE_USED.set((epoch, used + acquired.max(size)));
+    result
+}
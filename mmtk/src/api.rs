@@ -6,9 +6,11 @@ use crate::UPCALLS;
 use libc::c_char;
 use mmtk::memory_manager;
 use mmtk::plan::BarrierSelector;
+use mmtk::policy::space::Space;
 use mmtk::scheduler::GCWorker;
 use mmtk::util::alloc::AllocatorSelector;
 use mmtk::util::api_util::NullableObjectReference;
+use mmtk::util::conversions;
 use mmtk::util::opaque_pointer::*;
 use mmtk::util::{Address, ObjectReference};
 use mmtk::AllocationSemantics;
@@ -169,7 +171,16 @@ pub extern "C" fn alloc(
     offset: usize,
     allocator: AllocationSemantics,
 ) -> Address {
-    with_mutator!(|mutator| memory_manager::alloc(mutator, size, align, offset, allocator))
+    with_mutator!(|mutator| crate::allocation_reserve::alloc(
+        mutator, size, align, offset, allocator
+    ))
+}
+
+/// Set the bytes each mutator may allocate beyond the heap limit while a GC is pending, instead
+/// of blocking in the allocation slow path.  0 (the default) disables the reserve.
+#[no_mangle]
+pub extern "C" fn mmtk_set_allocation_reserve_bytes(bytes: usize) {
+    crate::allocation_reserve::set_reserve_bytes(bytes)
 }
 
 #[no_mangle]
@@ -222,6 +233,34 @@ pub extern "C" fn initialize_collection(tls: VMThread) {
     with_singleton!(|singleton| memory_manager::initialize_collection(singleton, tls))
 }
 
+/// Whether the plan is generational, i.e. whether it has nursery collections.
+#[no_mangle]
+pub extern "C" fn mmtk_is_generational() -> bool {
+    with_singleton!(|singleton| singleton.get_plan().generational().is_some())
+}
+
+/// Whether the plan does concurrent work between its pauses.
+#[no_mangle]
+pub extern "C" fn mmtk_is_concurrent() -> bool {
+    with_singleton!(|singleton| singleton.get_plan().concurrent().is_some())
+}
+
+/// Whether the current GC is a nursery GC.  Only meaningful while a GC is in progress.
+#[no_mangle]
+pub extern "C" fn mmtk_is_current_gc_nursery() -> bool {
+    with_singleton!(|singleton| singleton
+        .get_plan()
+        .generational()
+        .is_some_and(|gen| gen.is_current_gc_nursery()))
+}
+
+/// Whether the current GC is an emergency GC, started because a normal GC could not free enough
+/// memory.  Only meaningful while a GC is in progress.
+#[no_mangle]
+pub extern "C" fn mmtk_is_emergency_collection() -> bool {
+    with_singleton!(|singleton| singleton.is_emergency_collection())
+}
+
 #[no_mangle]
 pub extern "C" fn used_bytes() -> usize {
     with_singleton!(|singleton| memory_manager::used_bytes(singleton))
@@ -237,6 +276,77 @@ pub extern "C" fn total_bytes() -> usize {
     with_singleton!(|singleton| memory_manager::total_bytes(singleton))
 }
 
+/// Call `f` with the `index`-th space of the plan, in the order of `Plan::for_each_space`.
+/// Return `None` if there is no such space.
+fn with_space<VM: mmtk::vm::VMBinding, R>(
+    mmtk: &'static mmtk::MMTK<VM>,
+    index: usize,
+    f: impl FnOnce(&dyn Space<VM>) -> R,
+) -> Option<R> {
+    let mut f = Some(f);
+    let mut result = None;
+    let mut i = 0;
+    mmtk.get_plan().for_each_space(&mut |space| {
+        if i == index {
+            result = f.take().map(|f| f(space));
+        }
+        i += 1;
+    });
+    result
+}
+
+/// The number of spaces in the plan.  Spaces are identified by their index in
+/// `[0, mmtk_get_space_count())`, which does not change during the execution.
+#[no_mangle]
+pub extern "C" fn mmtk_get_space_count() -> usize {
+    with_singleton!(|singleton| {
+        let mut count = 0;
+        singleton.get_plan().for_each_space(&mut |_| count += 1);
+        count
+    })
+}
+
+/// Copy the name of the `index`-th space into `buf` as a NUL-terminated string, truncated to
+/// `len - 1` bytes.  Return the length of the full name, or 0 if there is no such space.
+#[no_mangle]
+pub extern "C" fn mmtk_get_space_name(index: usize, buf: *mut u8, len: usize) -> usize {
+    let name = with_singleton!(|singleton| with_space(singleton, index, |space| space.name()));
+    let Some(name) = name else {
+        return 0;
+    };
+    if len > 0 {
+        let n = usize::min(name.len(), len - 1);
+        unsafe {
+            std::ptr::copy_nonoverlapping(name.as_ptr(), buf, n);
+            *buf.add(n) = 0;
+        }
+    }
+    name.len()
+}
+
+/// Get the bytes used and committed by the `index`-th space.  "Used" is the pages reserved by the
+/// space, including its side metadata.  "Committed" is the pages mapped for the space.  Return
+/// false if there is no such space.
+#[no_mangle]
+pub extern "C" fn mmtk_get_space_usage(
+    index: usize,
+    used: *mut usize,
+    committed: *mut usize,
+) -> bool {
+    let usage = with_singleton!(|singleton| with_space(singleton, index, |space| (
+        space.reserved_pages(),
+        space.get_page_resource().committed_pages()
+    )));
+    let Some((reserved_pages, committed_pages)) = usage else {
+        return false;
+    };
+    unsafe {
+        *used = conversions::pages_to_bytes(reserved_pages);
+        *committed = conversions::pages_to_bytes(committed_pages);
+    }
+    true
+}
+
 #[no_mangle]
 pub extern "C" fn handle_user_collection_request(tls: VMMutatorThread) {
     with_singleton!(|singleton| {
@@ -264,6 +374,20 @@ pub extern "C" fn is_mapped_address(addr: Address) -> bool {
     memory_manager::is_mapped_address(addr)
 }
 
+/// Call `visitor(object, data)` for every object in the MMTk heap.  Objects are found through
+/// their VO bits, so the binding must be built with the `vo_bit` feature.  Must only be called
+/// while no mutator is allocating and no GC is running, e.g. at a safepoint.
+#[cfg(feature = "vo_bit")]
+#[no_mangle]
+pub extern "C" fn mmtk_enumerate_objects(
+    visitor: extern "C" fn(object: ObjectReference, data: *mut libc::c_void),
+    data: *mut libc::c_void,
+) {
+    with_singleton!(|singleton| {
+        memory_manager::enumerate_objects(singleton, |object| visitor(object, data))
+    })
+}
+
 #[no_mangle]
 pub extern "C" fn add_weak_candidate(reff: ObjectReference) {
     with_singleton!(|singleton| memory_manager::add_weak_candidate(singleton, reff))
@@ -279,6 +403,14 @@ pub extern "C" fn add_phantom_candidate(reff: ObjectReference) {
     with_singleton!(|singleton| memory_manager::add_phantom_candidate(singleton, reff))
 }
 
+/// Set the LRU policy for soft references in the coming GC.  A `SoftReference` whose `timestamp`
+/// is more than `max_interval` milliseconds behind `clock` is cleared once its referent is not
+/// strongly reachable.  Other soft references keep their referents alive.
+#[no_mangle]
+pub extern "C" fn mmtk_set_soft_reference_policy(clock: i64, max_interval: i64) {
+    crate::reference_glue::set_soft_reference_policy(clock, max_interval)
+}
+
 // The harness_begin()/end() functions are different than other API functions in terms of the thread state.
 // Other functions are called by the VM, thus the thread should already be in the VM state. But the harness
 // functions are called by the probe, and the thread is in JNI/application/native state. Thus we need call
@@ -490,6 +622,46 @@ pub extern "C" fn get_finalized_object() -> NullableObjectReference {
     with_singleton!(|singleton| memory_manager::get_finalized_object(singleton).into())
 }
 
+/// Move up to `capacity` objects that are ready for finalization into `buf`, and return the
+/// number of objects written.  Saves a call across the FFI boundary per object when the
+/// finalizer thread has a backlog.  It is not a batched drain: mmtk-core only exposes
+/// `get_finalized_object`, which takes the finalizable processor's lock once per object.
+#[no_mangle]
+pub extern "C" fn get_finalized_objects(buf: *mut ObjectReference, capacity: usize) -> usize {
+    let buf = unsafe { std::slice::from_raw_parts_mut(buf, capacity) };
+    let mut count = 0;
+    with_singleton!(|singleton| {
+        while count < capacity {
+            match memory_manager::get_finalized_object(singleton) {
+                Some(object) => {
+                    buf[count] = object;
+                    count += 1;
+                }
+                None => break,
+            }
+        }
+    });
+    if count > 0 {
+        probe!(mmtk_openjdk, finalizer_batch, count);
+    }
+    count
+}
+
+/// Fire the `stw_request` probe when a GC worker asks the companion thread to stop (`state` is 0)
+/// or resume (`state` is 1) the mutators.  The companion thread is implemented in C++, but all the
+/// probes of the binding live in this library so that one bpftrace script can attach to them.
+#[no_mangle]
+pub extern "C" fn mmtk_probe_stw_request(state: i32) {
+    probe!(mmtk_openjdk, stw_request, state);
+}
+
+/// Fire the `stw_reached` probe when the VM thread has stopped (`state` is 0) or is about to
+/// resume (`state` is 1) the mutators.
+#[no_mangle]
+pub extern "C" fn mmtk_probe_stw_reached(state: i32) {
+    probe!(mmtk_openjdk, stw_reached, state);
+}
+
 thread_local! {
     /// Cache reference slots of an nmethod while the current thread is executing
     /// `MMTkRegisterNMethodOopClosure`.
@@ -511,8 +683,7 @@ pub extern "C" fn mmtk_add_nmethod_oop(addr: Address) {
 pub extern "C" fn mmtk_register_nmethod(nm: Address) {
     NMETHOD_SLOTS.with_borrow_mut(|slots| {
         if !slots.is_empty() {
-            let mut roots = crate::NURSERY_CODE_CACHE_ROOTS.lock().unwrap();
-            roots.insert(nm, std::mem::take(slots));
+            crate::CODE_CACHE_ROOTS.register(nm, std::mem::take(slots));
         }
     });
 }
@@ -520,12 +691,5 @@ pub extern "C" fn mmtk_register_nmethod(nm: Address) {
 /// Unregister an nmethod.
 #[no_mangle]
 pub extern "C" fn mmtk_unregister_nmethod(nm: Address) {
-    {
-        let mut roots = crate::NURSERY_CODE_CACHE_ROOTS.lock().unwrap();
-        roots.remove(&nm);
-    }
-    {
-        let mut roots = crate::MATURE_CODE_CACHE_ROOTS.lock().unwrap();
-        roots.remove(&nm);
-    }
+    crate::CODE_CACHE_ROOTS.unregister(nm);
 }
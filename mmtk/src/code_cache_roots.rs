@@ -0,0 +1,58 @@
+use mmtk::util::Address;
+use std::collections::HashMap;
+use std::sync::{Mutex, MutexGuard};
+
+/// log2 of the number of shards of the code cache roots.
+const LOG_NUM_SHARDS: usize = 5;
+/// The number of shards of the code cache roots.  Each shard is scanned by its own work packet.
+pub const NUM_SHARDS: usize = 1 << LOG_NUM_SHARDS;
+
+/// The reference slots of the nmethods that hash to one shard.
+#[derive(Default)]
+pub struct CodeCacheRootsShard {
+    /// Slots of nmethods added since the last GC.
+    pub nursery: HashMap<Address, Vec<Address>>,
+    /// Slots of nmethods added before the last GC.
+    pub mature: HashMap<Address, Vec<Address>>,
+}
+
+/// The remembered set of reference slots in compiled code, keyed by nmethod address.
+///
+/// nmethods are spread over `NUM_SHARDS` independently locked shards.  Compiler threads
+/// registering or unregistering different nmethods rarely contend on the same lock, and GC workers
+/// can scan the shards in parallel.
+pub struct CodeCacheRoots {
+    shards: [Mutex<CodeCacheRootsShard>; NUM_SHARDS],
+}
+
+impl CodeCacheRoots {
+    pub fn new() -> Self {
+        Self {
+            shards: std::array::from_fn(|_| Mutex::new(CodeCacheRootsShard::default())),
+        }
+    }
+
+    fn shard_index(nm: Address) -> usize {
+        // nmethods are aligned to `CodeEntryAlignment`. Hash the address so that neighbouring
+        // nmethods do not all land in the same shard.
+        (nm.as_usize() >> 4).wrapping_mul(0x9E37_79B9_7F4A_7C15)
+            >> (usize::BITS as usize - LOG_NUM_SHARDS)
+    }
+
+    /// Lock the shard with the given index.
+    pub fn shard(&self, index: usize) -> MutexGuard<CodeCacheRootsShard> {
+        self.shards[index].lock().unwrap()
+    }
+
+    /// Record the reference slots of a newly registered nmethod.
+    pub fn register(&self, nm: Address, slots: Vec<Address>) {
+        self.shard(Self::shard_index(nm)).nursery.insert(nm, slots);
+    }
+
+    /// Forget the reference slots of an nmethod.
+    pub fn unregister(&self, nm: Address) {
+        let mut shard = self.shard(Self::shard_index(nm));
+        shard.nursery.remove(&nm);
+        shard.mature.remove(&nm);
+    }
+}
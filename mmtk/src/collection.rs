@@ -3,8 +3,8 @@ use mmtk::util::opaque_pointer::*;
 use mmtk::vm::{Collection, GCThreadContext};
 use mmtk::Mutator;
 
+use crate::OpenJDK;
 use crate::{singleton, UPCALLS};
-use crate::{MutatorClosure, OpenJDK};
 
 pub struct VMCollection {}
 
@@ -16,10 +16,12 @@ impl<const COMPRESSED: bool> Collection<OpenJDK<COMPRESSED>> for VMCollection {
         F: FnMut(&'static mut Mutator<OpenJDK<COMPRESSED>>),
     {
         unsafe {
-            ((*UPCALLS).stop_all_mutators)(
-                tls,
-                MutatorClosure::from_rust_closure::<_, COMPRESSED>(&mut mutator_visitor),
-            );
+            ((*UPCALLS).stop_all_mutators)(tls);
+        }
+        let mutators = crate::active_plan::mutators_snapshot::<COMPRESSED>()
+            .expect("the mutators have just been stopped");
+        for mutator in mutators {
+            mutator_visitor(unsafe { &mut **mutator });
         }
     }
 
@@ -36,15 +38,18 @@ impl<const COMPRESSED: bool> Collection<OpenJDK<COMPRESSED>> for VMCollection {
             }
             log::debug!("Set CONCURRENT_MARKING_ACTIVE to {concurrent_marking_active}");
         }
+        crate::allocation_reserve::on_mutators_resumed();
         unsafe {
             ((*UPCALLS).resume_mutators)(tls);
         }
     }
 
     fn block_for_gc(_tls: VMMutatorThread) {
+        probe!(mmtk_openjdk, block_for_gc_start);
         unsafe {
             ((*UPCALLS).block_for_gc)();
         }
+        probe!(mmtk_openjdk, block_for_gc_end);
     }
 
     fn spawn_gc_thread(tls: VMThread, ctx: GCThreadContext<OpenJDK<COMPRESSED>>) {
@@ -3,14 +3,112 @@ use crate::scanning::to_slots_closure;
 use crate::OpenJDK;
 use crate::OpenJDKSlot;
 use crate::UPCALLS;
+use mmtk::policy::space::Space;
 use mmtk::scheduler::*;
-use mmtk::util::Address;
+use mmtk::util::{Address, ObjectReference};
+use mmtk::vm::slot::Slot;
 use mmtk::vm::RootsWorkFactory;
 use mmtk::vm::*;
 use mmtk::MMTK;
 
+/// A `RootsWorkFactory` used in nursery GCs that drops root slots which cannot point to a young
+/// object.
+///
+/// Objects in the mature spaces and the immortal spaces neither move nor die in a nursery GC, so
+/// their slots do not need to be processed.  This keeps the large, mostly long-lived root sets
+/// (such as JNI global handles and inflated monitors) from producing work in every nursery GC.
+/// Slots pointing to the large object space are always kept because it holds young objects, too.
+pub struct NurseryRootsFilter<VM: VMBinding, F: RootsWorkFactory<VM::VMSlot>> {
+    factory: F,
+    mmtk: &'static MMTK<VM>,
+}
+
+impl<VM: VMBinding, F: RootsWorkFactory<VM::VMSlot>> NurseryRootsFilter<VM, F> {
+    pub fn new(factory: F, mmtk: &'static MMTK<VM>) -> Self {
+        Self { factory, mmtk }
+    }
+}
+
+impl<VM: VMBinding, F: RootsWorkFactory<VM::VMSlot>> Clone for NurseryRootsFilter<VM, F> {
+    fn clone(&self) -> Self {
+        Self::new(self.factory.clone(), self.mmtk)
+    }
+}
+
+impl<VM: VMBinding, F: RootsWorkFactory<VM::VMSlot>> RootsWorkFactory<VM::VMSlot>
+    for NurseryRootsFilter<VM, F>
+{
+    fn create_process_roots_work(&mut self, mut slots: Vec<VM::VMSlot>) {
+        let plan = self.mmtk.get_plan();
+        let gen = plan.generational().unwrap();
+        let los = plan.common().get_los();
+        slots.retain(|slot| {
+            slot.load()
+                .is_some_and(|object| gen.is_object_in_nursery(object) || los.in_space(object))
+        });
+        if !slots.is_empty() {
+            self.factory.create_process_roots_work(slots);
+        }
+    }
+
+    fn create_process_pinning_roots_work(&mut self, nodes: Vec<ObjectReference>) {
+        self.factory.create_process_pinning_roots_work(nodes);
+    }
+
+    fn create_process_tpinning_roots_work(&mut self, nodes: Vec<ObjectReference>) {
+        self.factory.create_process_tpinning_roots_work(nodes);
+    }
+}
+
+/// A `RootsWorkFactory` that counts the root slots reported to it, for the `roots` probe.
+#[derive(Clone)]
+pub struct CountingRootsFactory<F> {
+    factory: F,
+    slots: usize,
+}
+
+impl<F> CountingRootsFactory<F> {
+    pub fn new(factory: F) -> Self {
+        Self { factory, slots: 0 }
+    }
+}
+
+impl<S: Slot, F: RootsWorkFactory<S>> RootsWorkFactory<S> for CountingRootsFactory<F> {
+    fn create_process_roots_work(&mut self, slots: Vec<S>) {
+        self.slots += slots.len();
+        self.factory.create_process_roots_work(slots);
+    }
+
+    fn create_process_pinning_roots_work(&mut self, nodes: Vec<ObjectReference>) {
+        self.factory.create_process_pinning_roots_work(nodes);
+    }
+
+    fn create_process_tpinning_roots_work(&mut self, nodes: Vec<ObjectReference>) {
+        self.factory.create_process_tpinning_roots_work(nodes);
+    }
+}
+
+/// Scan one root category with `scan`, and fire the `roots` probe with the name of the category
+/// and the number of slots the VM reported.  In a nursery GC, the count is taken before
+/// `NurseryRootsFilter` drops any slots.
+pub(crate) fn scan_and_count_roots<S: Slot, F: RootsWorkFactory<S>>(
+    category: &'static str,
+    factory: F,
+    scan: impl FnOnce(&mut CountingRootsFactory<F>),
+) {
+    let mut factory = CountingRootsFactory::new(factory);
+    scan(&mut factory);
+    probe!(mmtk_openjdk, roots, category.as_ptr(), factory.slots);
+}
+
 macro_rules! scan_roots_work {
     ($struct_name: ident, $func_name: ident) => {
+        scan_roots_work!($struct_name, $func_name, false);
+    };
+    ($struct_name: ident, $func_name: ident, nursery_filtered) => {
+        scan_roots_work!($struct_name, $func_name, true);
+    };
+    ($struct_name: ident, $func_name: ident, $nursery_filtered: expr) => {
         pub struct $struct_name<VM: VMBinding, F: RootsWorkFactory<VM::VMSlot>> {
             factory: F,
             _p: std::marker::PhantomData<VM>,
@@ -26,9 +124,21 @@ macro_rules! scan_roots_work {
         }
 
         impl<VM: VMBinding, F: RootsWorkFactory<VM::VMSlot>> GCWork<VM> for $struct_name<VM, F> {
-            fn do_work(&mut self, _worker: &mut GCWorker<VM>, _mmtk: &'static MMTK<VM>) {
-                unsafe {
-                    ((*UPCALLS).$func_name)(to_slots_closure(&mut self.factory));
+            fn do_work(&mut self, _worker: &mut GCWorker<VM>, mmtk: &'static MMTK<VM>) {
+                let is_current_gc_nursery = mmtk
+                    .get_plan()
+                    .generational()
+                    .is_some_and(|gen| gen.is_current_gc_nursery());
+                let category = concat!(stringify!($func_name), "\0");
+                if $nursery_filtered && is_current_gc_nursery {
+                    let factory = NurseryRootsFilter::new(self.factory.clone(), mmtk);
+                    scan_and_count_roots(category, factory, |factory| unsafe {
+                        ((*UPCALLS).$func_name)(to_slots_closure::<VM::VMSlot, _>(factory));
+                    });
+                } else {
+                    scan_and_count_roots(category, self.factory.clone(), |factory| unsafe {
+                        ((*UPCALLS).$func_name)(to_slots_closure::<VM::VMSlot, _>(factory));
+                    });
                 }
             }
         }
@@ -36,30 +146,71 @@ macro_rules! scan_roots_work {
 }
 
 scan_roots_work!(ScanUniverseRoots, scan_universe_roots);
-scan_roots_work!(ScanJNIHandlesRoots, scan_jni_handle_roots);
-scan_roots_work!(ScanObjectSynchronizerRoots, scan_object_synchronizer_roots);
-scan_roots_work!(ScanManagementRoots, scan_management_roots);
+scan_roots_work!(ScanJNIHandlesRoots, scan_jni_handle_roots, nursery_filtered);
+scan_roots_work!(
+    ScanObjectSynchronizerRoots,
+    scan_object_synchronizer_roots,
+    nursery_filtered
+);
+scan_roots_work!(ScanManagementRoots, scan_management_roots, nursery_filtered);
 scan_roots_work!(ScanJvmtiExportRoots, scan_jvmti_export_roots);
 scan_roots_work!(ScanAOTLoaderRoots, scan_aot_loader_roots);
 scan_roots_work!(ScanSystemDictionaryRoots, scan_system_dictionary_roots);
 scan_roots_work!(ScanStringTableRoots, scan_string_table_roots);
-scan_roots_work!(
-    ScanClassLoaderDataGraphRoots,
-    scan_class_loader_data_graph_roots
-);
 scan_roots_work!(ScanWeakProcessorRoots, scan_weak_processor_roots);
 scan_roots_work!(ScanVMThreadRoots, scan_vm_thread_roots);
 
+pub struct ScanClassLoaderDataGraphRoots<
+    const COMPRESSED: bool,
+    F: RootsWorkFactory<OpenJDKSlot<COMPRESSED>>,
+> {
+    factory: F,
+}
+
+impl<const COMPRESSED: bool, F: RootsWorkFactory<OpenJDKSlot<COMPRESSED>>>
+    ScanClassLoaderDataGraphRoots<COMPRESSED, F>
+{
+    pub fn new(factory: F) -> Self {
+        Self { factory }
+    }
+}
+
+impl<const COMPRESSED: bool, F: RootsWorkFactory<OpenJDKSlot<COMPRESSED>>>
+    GCWork<OpenJDK<COMPRESSED>> for ScanClassLoaderDataGraphRoots<COMPRESSED, F>
+{
+    fn do_work(
+        &mut self,
+        _worker: &mut GCWorker<OpenJDK<COMPRESSED>>,
+        mmtk: &'static MMTK<OpenJDK<COMPRESSED>>,
+    ) {
+        // Like the code cache roots, the class loader data graph is treated as a remembered set:
+        // nursery GCs only visit the CLDs that gained new oops since the last GC.
+        let is_current_gc_nursery = mmtk
+            .get_plan()
+            .generational()
+            .is_some_and(|gen| gen.is_current_gc_nursery());
+        let category = "scan_class_loader_data_graph_roots\0";
+        scan_and_count_roots(category, self.factory.clone(), |factory| unsafe {
+            ((*UPCALLS).scan_class_loader_data_graph_roots)(
+                to_slots_closure::<OpenJDKSlot<COMPRESSED>, _>(factory),
+                !is_current_gc_nursery,
+            );
+        });
+    }
+}
+
+/// Scan the cached code cache roots in one shard of `CODE_CACHE_ROOTS`.
 pub struct ScanCodeCacheRoots<const COMPRESSED: bool, F: RootsWorkFactory<OpenJDKSlot<COMPRESSED>>>
 {
     factory: F,
+    shard: usize,
 }
 
 impl<const COMPRESSED: bool, F: RootsWorkFactory<OpenJDKSlot<COMPRESSED>>>
     ScanCodeCacheRoots<COMPRESSED, F>
 {
-    pub fn new(factory: F) -> Self {
-        Self { factory }
+    pub fn new(factory: F, shard: usize) -> Self {
+        Self { factory, shard }
     }
 }
 
@@ -92,23 +243,21 @@ impl<const COMPRESSED: bool, F: RootsWorkFactory<OpenJDKSlot<COMPRESSED>>>
         };
 
         {
-            let mut mature = crate::MATURE_CODE_CACHE_ROOTS.lock().unwrap();
+            let mut shard = crate::CODE_CACHE_ROOTS.shard(self.shard);
+            let shard = &mut *shard;
 
             // Only scan mature roots in full-heap collections.
             if !is_current_gc_nursery {
-                for roots in mature.values() {
+                for roots in shard.mature.values() {
                     mature_slots += roots.len();
                     add_roots(roots);
                 }
             }
 
-            {
-                let mut nursery = crate::NURSERY_CODE_CACHE_ROOTS.lock().unwrap();
-                for (key, roots) in nursery.drain() {
-                    nursery_slots += roots.len();
-                    add_roots(&roots);
-                    mature.insert(key, roots);
-                }
+            for (key, roots) in shard.nursery.drain() {
+                nursery_slots += roots.len();
+                add_roots(&roots);
+                shard.mature.insert(key, roots);
             }
         }
 
@@ -3,7 +3,6 @@ extern crate lazy_static;
 #[macro_use]
 extern crate probe;
 
-use std::collections::HashMap;
 use std::ptr::null_mut;
 use std::sync::Mutex;
 
@@ -21,8 +20,10 @@ use slots::{OpenJDKSlot, OpenJDKSlotRange};
 
 mod abi;
 pub mod active_plan;
+mod allocation_reserve;
 pub mod api;
 mod build_info;
+mod code_cache_roots;
 pub mod collection;
 mod gc_work;
 pub mod object_model;
@@ -82,12 +83,13 @@ pub struct SlotsClosure {
 
 #[repr(C)]
 pub struct OpenJDK_Upcalls {
-    pub stop_all_mutators: extern "C" fn(tls: VMWorkerThread, closure: MutatorClosure),
+    pub stop_all_mutators: extern "C" fn(tls: VMWorkerThread),
     pub resume_mutators: extern "C" fn(tls: VMWorkerThread),
     pub spawn_gc_thread: extern "C" fn(tls: VMThread, kind: libc::c_int, ctx: *mut libc::c_void),
     pub block_for_gc: extern "C" fn(),
     pub out_of_memory: extern "C" fn(tls: VMThread, err_kind: AllocationError),
-    pub get_mutators: extern "C" fn(closure: MutatorClosure),
+    pub get_mutators: extern "C" fn(len: *mut usize) -> *const *mut libc::c_void,
+    pub get_live_mutators: extern "C" fn(closure: MutatorClosure),
     pub scan_object: extern "C" fn(trace: *mut c_void, object: ObjectReference, tls: OpaquePointer),
     pub dump_object: extern "C" fn(object: ObjectReference),
     pub get_object_size: extern "C" fn(object: ObjectReference) -> usize,
@@ -100,8 +102,8 @@ pub struct OpenJDK_Upcalls {
     pub static_oop_field_count_offset: extern "C" fn() -> i32,
     pub referent_offset: extern "C" fn() -> i32,
     pub discovered_offset: extern "C" fn() -> i32,
+    pub soft_reference_timestamp_offset: extern "C" fn() -> i32,
     pub dump_object_string: extern "C" fn(object: ObjectReference) -> *const c_char,
-    pub scan_roots_in_all_mutator_threads: extern "C" fn(closure: SlotsClosure),
     pub scan_roots_in_mutator_thread: extern "C" fn(closure: SlotsClosure, tls: VMMutatorThread),
     pub scan_universe_roots: extern "C" fn(closure: SlotsClosure),
     pub scan_jni_handle_roots: extern "C" fn(closure: SlotsClosure),
@@ -112,7 +114,7 @@ pub struct OpenJDK_Upcalls {
     pub scan_system_dictionary_roots: extern "C" fn(closure: SlotsClosure),
     pub scan_code_cache_roots: extern "C" fn(closure: SlotsClosure),
     pub scan_string_table_roots: extern "C" fn(closure: SlotsClosure),
-    pub scan_class_loader_data_graph_roots: extern "C" fn(closure: SlotsClosure),
+    pub scan_class_loader_data_graph_roots: extern "C" fn(closure: SlotsClosure, scan_all: bool),
     pub scan_weak_processor_roots: extern "C" fn(closure: SlotsClosure),
     pub scan_vm_thread_roots: extern "C" fn(closure: SlotsClosure),
     pub number_of_mutators: extern "C" fn() -> usize,
@@ -206,10 +208,8 @@ pub static MMTK_MARK_COMPACT_HEADER_RESERVED_IN_BYTES: usize =
     mmtk::util::alloc::MarkCompactAllocator::<OpenJDK<false>>::HEADER_RESERVED_IN_BYTES;
 
 lazy_static! {
-    /// A global storage for all the cached CodeCache roots added since the last GC.
-    static ref NURSERY_CODE_CACHE_ROOTS: Mutex<HashMap<Address, Vec<Address>>> = Mutex::new(HashMap::new());
-    /// A global storage for all the cached CodeCache roots added before the last GC.
-    static ref MATURE_CODE_CACHE_ROOTS: Mutex<HashMap<Address, Vec<Address>>> = Mutex::new(HashMap::new());
+    /// A global storage for all the cached CodeCache roots.
+    static ref CODE_CACHE_ROOTS: code_cache_roots::CodeCacheRoots = code_cache_roots::CodeCacheRoots::new();
 }
 
 fn set_compressed_pointer_vm_layout(builder: &mut MMTKBuilder) {
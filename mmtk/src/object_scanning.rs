@@ -1,15 +1,58 @@
-use crate::OpenJDKSlot;
+use crate::{OpenJDKSlot, OpenJDKSlotRange};
 
 use super::abi::*;
 use super::UPCALLS;
 use mmtk::util::opaque_pointer::*;
 use mmtk::util::{Address, ObjectReference};
+use mmtk::vm::slot::{MemorySlice, Slot};
 use mmtk::vm::SlotVisitor;
 use std::cell::UnsafeCell;
-use std::{mem, slice};
+use std::mem;
 
 type S<const COMPRESSED: bool> = OpenJDKSlot<COMPRESSED>;
 
+/// When visiting a run of contiguous slots, prefetch the referent of the slot this many slots
+/// ahead of the one being visited.  Tracing is dominated by cache misses on the headers of the
+/// referents, and this gives the memory system time to bring them in.
+const PREFETCH_DISTANCE: usize = 8;
+
+/// Object arrays with more elements than this are enumerated without prefetching.  Their slots
+/// span several work packets.
+const LARGE_OBJ_ARRAY_SLOTS: usize = crate::scanning::WORK_PACKET_CAPACITY;
+
+/// Prefetch the header of the object `slot` points to, if any.
+#[inline(always)]
+fn prefetch_referent<const COMPRESSED: bool>(slot: S<COMPRESSED>) {
+    #[cfg(target_arch = "x86_64")]
+    if let Some(object) = slot.load() {
+        use std::arch::x86_64::{_mm_prefetch, _MM_HINT_T0};
+        unsafe { _mm_prefetch::<_MM_HINT_T0>(object.to_raw_address().to_ptr::<i8>()) }
+    }
+    #[cfg(not(target_arch = "x86_64"))]
+    let _ = slot;
+}
+
+/// Visit `count` contiguous slots starting at `start`, prefetching referents `PREFETCH_DISTANCE`
+/// slots ahead.
+#[inline(always)]
+fn visit_slots<const COMPRESSED: bool>(
+    start: Address,
+    count: usize,
+    closure: &mut impl SlotVisitor<S<COMPRESSED>>,
+) {
+    let slot_at =
+        |i: usize| S::<COMPRESSED>::from(start + (i << S::<COMPRESSED>::LOG_BYTES_IN_SLOT));
+    for i in 0..usize::min(PREFETCH_DISTANCE, count) {
+        prefetch_referent(slot_at(i));
+    }
+    for i in 0..count {
+        if i + PREFETCH_DISTANCE < count {
+            prefetch_referent(slot_at(i + PREFETCH_DISTANCE));
+        }
+        closure.visit_slot(slot_at(i));
+    }
+}
+
 trait OopIterate: Sized {
     fn oop_iterate<const COMPRESSED: bool>(
         &self,
@@ -24,12 +67,8 @@ impl OopIterate for OopMapBlock {
         oop: Oop,
         closure: &mut impl SlotVisitor<S<COMPRESSED>>,
     ) {
-        let log_bytes_in_oop = if COMPRESSED { 2 } else { 3 };
         let start = oop.get_field_address(self.offset);
-        for i in 0..self.count as usize {
-            let slot = (start + (i << log_bytes_in_oop)).into();
-            closure.visit_slot(slot);
-        }
+        visit_slots::<COMPRESSED>(start, self.count as usize, closure);
     }
 }
 
@@ -57,19 +96,7 @@ impl OopIterate for InstanceMirrorKlass {
         // static fields
         let start = Self::start_of_static_fields(oop);
         let len = Self::static_oop_field_count(oop);
-        if COMPRESSED {
-            let start: *const NarrowOop = start.to_ptr::<NarrowOop>();
-            let slice = unsafe { slice::from_raw_parts(start, len as _) };
-            for narrow_oop in slice {
-                closure.visit_slot(narrow_oop.slot().into());
-            }
-        } else {
-            let start: *const Oop = start.to_ptr::<Oop>();
-            let slice = unsafe { slice::from_raw_parts(start, len as _) };
-            for oop in slice {
-                closure.visit_slot(Address::from_ref(oop as &Oop).into());
-            }
-        }
+        visit_slots::<COMPRESSED>(start, len as usize, closure);
     }
 }
 
@@ -90,13 +117,24 @@ impl OopIterate for ObjArrayKlass {
         closure: &mut impl SlotVisitor<S<COMPRESSED>>,
     ) {
         let array = unsafe { oop.as_array_oop() };
-        if COMPRESSED {
-            for narrow_oop in unsafe { array.data::<NarrowOop, COMPRESSED>(BasicType::T_OBJECT) } {
-                closure.visit_slot(narrow_oop.slot().into());
-            }
+        let (start, len) = if COMPRESSED {
+            let data = unsafe { array.data::<NarrowOop, COMPRESSED>(BasicType::T_OBJECT) };
+            (Address::from_ptr(data.as_ptr()), data.len())
         } else {
-            for oop in unsafe { array.data::<Oop, COMPRESSED>(BasicType::T_OBJECT) } {
-                closure.visit_slot(Address::from_ref(oop as &Oop).into());
+            let data = unsafe { array.data::<Oop, COMPRESSED>(BasicType::T_OBJECT) };
+            (Address::from_ptr(data.as_ptr()), data.len())
+        };
+        if len <= LARGE_OBJ_ARRAY_SLOTS {
+            visit_slots::<COMPRESSED>(start, len, closure);
+        } else {
+            // The slot visitor hands every `WORK_PACKET_CAPACITY` slots it is given to a new
+            // work packet that any worker can take, so the elements of a large array are traced
+            // in parallel in fixed-size chunks while this worker only enumerates their addresses.
+            // Those chunks are traced long after this loop has moved on, so do not load the
+            // elements to prefetch their referents here.
+            let end = start + (len << S::<COMPRESSED>::LOG_BYTES_IN_SLOT);
+            for slot in OpenJDKSlotRange::<COMPRESSED>::from(start..end).iter_slots() {
+                closure.visit_slot(slot);
             }
         }
     }
@@ -120,7 +158,8 @@ impl OopIterate for InstanceRefKlass {
         closure: &mut impl SlotVisitor<S<COMPRESSED>>,
     ) {
         use crate::abi::*;
-        use crate::api::{add_phantom_candidate, add_soft_candidate, add_weak_candidate};
+        use crate::api::{add_phantom_candidate, add_weak_candidate};
+        use crate::reference_glue::should_clear_soft_reference;
         self.instance_klass.oop_iterate::<COMPRESSED>(oop, closure);
 
         // Unlike OpenJDK's built-in collectors, we do not use the `discovered` field for
@@ -138,7 +177,18 @@ impl OopIterate for InstanceRefKlass {
                     panic!("oop_iterate on InstanceRefKlass with reference_type as None")
                 }
                 ReferenceType::Weak => add_weak_candidate(reference),
-                ReferenceType::Soft => add_soft_candidate(reference),
+                // Soft references are handled with an LRU policy: a recently used one keeps its
+                // referent alive, and one that has not been used for long enough is treated as
+                // a weak reference.  They are never given to MMTk as soft candidates because
+                // MMTk keeps soft references it has seen, and retains all their referents in
+                // every later non-emergency GC.
+                ReferenceType::Soft => {
+                    if should_clear_soft_reference(oop) {
+                        add_weak_candidate(reference)
+                    } else {
+                        Self::process_ref_as_strong(oop, closure)
+                    }
+                }
                 ReferenceType::Phantom => add_phantom_candidate(reference),
                 // Process these two types normally (as if they are strong refs)
                 // We will handle final reference later
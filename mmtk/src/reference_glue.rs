@@ -1,10 +1,58 @@
 use crate::abi::{InstanceRefKlass, Oop};
 use crate::OpenJDK;
 use crate::UPCALLS;
+use mmtk::memory_manager;
+use mmtk::scheduler::{GCWork, GCWorker, WorkBucketStage};
 use mmtk::util::opaque_pointer::VMWorkerThread;
 use mmtk::util::ObjectReference;
 use mmtk::vm::slot::Slot;
 use mmtk::vm::ReferenceGlue;
+use mmtk::MMTK;
+use std::sync::atomic::{AtomicI64, Ordering};
+
+/// Lists of references no longer than this are enqueued directly by the calling worker.
+const ENQUEUE_REFERENCES_CHUNK_SIZE: usize = 4096;
+
+/// Link a partition of the references to be enqueued into a list and splice it onto the
+/// reference pending list.
+///
+/// `objects` may contain duplicated references.  Partitions are formed by hashing the references,
+/// so all copies of a reference are in the same partition and are deduplicated by the C++ side.
+struct EnqueueReferences {
+    references: Vec<ObjectReference>,
+}
+
+impl<const COMPRESSED: bool> GCWork<OpenJDK<COMPRESSED>> for EnqueueReferences {
+    fn do_work(
+        &mut self,
+        _worker: &mut GCWorker<OpenJDK<COMPRESSED>>,
+        _mmtk: &'static MMTK<OpenJDK<COMPRESSED>>,
+    ) {
+        unsafe {
+            ((*UPCALLS).enqueue_references)(self.references.as_ptr(), self.references.len());
+        }
+    }
+}
+
+/// `SoftReference.clock` at the start of the current GC, in milliseconds.
+static SOFT_REFERENCE_CLOCK: AtomicI64 = AtomicI64::new(0);
+/// Soft references that have not been accessed for more than this many milliseconds before the
+/// start of the current GC are treated as weak references.
+static SOFT_REFERENCE_MAX_INTERVAL: AtomicI64 = AtomicI64::new(i64::MAX);
+
+/// Set the soft reference clearing policy for the current GC.  See `mmtk_set_soft_reference_policy`.
+pub fn set_soft_reference_policy(clock: i64, max_interval: i64) {
+    SOFT_REFERENCE_CLOCK.store(clock, Ordering::Relaxed);
+    SOFT_REFERENCE_MAX_INTERVAL.store(max_interval, Ordering::Relaxed);
+}
+
+/// Return true if the LRU policy says that the `SoftReference` `reff` should be cleared when its
+/// referent is no longer strongly reachable, or false if its referent should be kept alive.
+pub fn should_clear_soft_reference(reff: Oop) -> bool {
+    let interval = SOFT_REFERENCE_CLOCK.load(Ordering::Relaxed)
+        - InstanceRefKlass::soft_reference_timestamp(reff);
+    interval > SOFT_REFERENCE_MAX_INTERVAL.load(Ordering::Relaxed)
+}
 
 pub struct VMReferenceGlue {}
 
@@ -20,9 +68,41 @@ impl<const COMPRESSED: bool> ReferenceGlue<OpenJDK<COMPRESSED>> for VMReferenceG
         InstanceRefKlass::referent_address::<COMPRESSED>(oop).load()
     }
     fn enqueue_references(references: &[ObjectReference], _tls: VMWorkerThread) {
-        unsafe {
-            ((*UPCALLS).enqueue_references)(references.as_ptr(), references.len());
+        probe!(mmtk_openjdk, enqueue_references, references.len());
+        if references.len() <= ENQUEUE_REFERENCES_CHUNK_SIZE {
+            unsafe {
+                ((*UPCALLS).enqueue_references)(references.as_ptr(), references.len());
+            }
+            return;
+        }
+
+        // Many references are cleared in this GC.  Linking them means loading and storing the
+        // `discovered` field of each, which is dominated by cache misses, so let all workers do
+        // it in parallel.  Each partition becomes its own list, and the C++ side splices each of
+        // them onto the pending list with one atomic swap.
+        let mmtk = crate::singleton::<COMPRESSED>();
+        let partitions = usize::min(
+            *mmtk.get_options().threads,
+            references.len().div_ceil(ENQUEUE_REFERENCES_CHUNK_SIZE),
+        );
+        let mut packets: Vec<EnqueueReferences> = (0..partitions)
+            .map(|_| EnqueueReferences {
+                references: Vec::with_capacity(references.len() / partitions + 1),
+            })
+            .collect();
+        for reference in references {
+            // References are word-aligned.  Drop the zero bits before hashing.
+            let hash = reference.to_raw_address().as_usize() >> 3;
+            packets[hash % partitions].references.push(*reference);
         }
+        memory_manager::add_work_packets(
+            mmtk,
+            WorkBucketStage::Release,
+            packets
+                .into_iter()
+                .map(|packet| Box::new(packet) as Box<dyn GCWork<OpenJDK<COMPRESSED>>>)
+                .collect(),
+        );
     }
     fn clear_referent(new_reference: ObjectReference) {
         let oop = Oop::from(new_reference);
@@ -3,7 +3,7 @@ use crate::Slot;
 use crate::{NewBuffer, OpenJDKSlot, UPCALLS};
 use crate::{OpenJDK, SlotsClosure};
 use mmtk::memory_manager;
-use mmtk::scheduler::WorkBucketStage;
+use mmtk::scheduler::{GCWork, WorkBucketStage};
 use mmtk::util::opaque_pointer::*;
 use mmtk::util::{Address, ObjectReference};
 use mmtk::vm::{RootsWorkFactory, Scanning, SlotVisitor};
@@ -58,39 +58,49 @@ impl<const COMPRESSED: bool> Scanning<OpenJDK<COMPRESSED>> for VMScanning {
         // TODO
     }
 
+    /// mmtk-core creates one `ScanMutatorRoots` packet for each mutator reported by
+    /// `stop_all_mutators`, so each `JavaThread` stack is scanned by whichever worker
+    /// claims its packet, and stack scanning scales with the number of GC workers.
     fn scan_roots_in_mutator_thread(
         _tls: VMWorkerThread,
         mutator: &'static mut Mutator<OpenJDK<COMPRESSED>>,
-        mut factory: impl RootsWorkFactory<OpenJDKSlot<COMPRESSED>>,
+        factory: impl RootsWorkFactory<OpenJDKSlot<COMPRESSED>>,
     ) {
         let tls = mutator.get_tls();
-        unsafe {
-            ((*UPCALLS).scan_roots_in_mutator_thread)(to_slots_closure(&mut factory), tls);
-        }
+        let category = "scan_roots_in_mutator_thread\0";
+        crate::gc_work::scan_and_count_roots(category, factory, |factory| unsafe {
+            let closure = to_slots_closure::<OpenJDKSlot<COMPRESSED>, _>(factory);
+            ((*UPCALLS).scan_roots_in_mutator_thread)(closure, tls);
+        });
     }
 
     fn scan_vm_specific_roots(
         _tls: VMWorkerThread,
         factory: impl RootsWorkFactory<OpenJDKSlot<COMPRESSED>>,
     ) {
-        memory_manager::add_work_packets(
-            crate::singleton::<COMPRESSED>(),
-            WorkBucketStage::Prepare,
-            vec![
-                Box::new(ScanUniverseRoots::new(factory.clone())) as _,
-                Box::new(ScanJNIHandlesRoots::new(factory.clone())) as _,
-                Box::new(ScanObjectSynchronizerRoots::new(factory.clone())) as _,
-                Box::new(ScanManagementRoots::new(factory.clone())) as _,
-                Box::new(ScanJvmtiExportRoots::new(factory.clone())) as _,
-                Box::new(ScanAOTLoaderRoots::new(factory.clone())) as _,
-                Box::new(ScanSystemDictionaryRoots::new(factory.clone())) as _,
-                Box::new(ScanCodeCacheRoots::new(factory.clone())) as _,
-                Box::new(ScanStringTableRoots::new(factory.clone())) as _,
-                Box::new(ScanClassLoaderDataGraphRoots::new(factory.clone())) as _,
-                Box::new(ScanWeakProcessorRoots::new(factory.clone())) as _,
-                Box::new(ScanVMThreadRoots::new(factory)) as _,
-            ],
-        );
+        let mmtk = crate::singleton::<COMPRESSED>();
+        let mut packets: Vec<Box<dyn GCWork<OpenJDK<COMPRESSED>>>> = vec![
+            Box::new(ScanUniverseRoots::new(factory.clone())) as _,
+            Box::new(ScanJNIHandlesRoots::new(factory.clone())) as _,
+            Box::new(ScanObjectSynchronizerRoots::new(factory.clone())) as _,
+            Box::new(ScanManagementRoots::new(factory.clone())) as _,
+            Box::new(ScanJvmtiExportRoots::new(factory.clone())) as _,
+            Box::new(ScanAOTLoaderRoots::new(factory.clone())) as _,
+            Box::new(ScanSystemDictionaryRoots::new(factory.clone())) as _,
+            Box::new(ScanClassLoaderDataGraphRoots::new(factory.clone())) as _,
+            Box::new(ScanWeakProcessorRoots::new(factory.clone())) as _,
+            Box::new(ScanVMThreadRoots::new(factory.clone())) as _,
+        ];
+        for shard in 0..crate::code_cache_roots::NUM_SHARDS {
+            packets.push(Box::new(ScanCodeCacheRoots::new(factory.clone(), shard)));
+        }
+        // The string table can hold millions of entries.  Give every worker a packet that claims
+        // chunks of it from a shared `ParState` on the C++ side so that one huge table does not
+        // end up on the critical path of the Prepare stage.
+        for _ in 0..*mmtk.get_options().threads {
+            packets.push(Box::new(ScanStringTableRoots::new(factory.clone())));
+        }
+        memory_manager::add_work_packets(mmtk, WorkBucketStage::Prepare, packets);
     }
 
     fn supports_return_barrier() -> bool {
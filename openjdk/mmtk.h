@@ -72,6 +72,7 @@ extern void release_buffer(void** buffer, size_t len, size_t cap);
 
 extern bool is_in_mmtk_spaces(void* ref);
 extern bool is_mapped_address(void* addr);
+extern void mmtk_enumerate_objects(void (*visitor)(void* object, void* data), void* data);
 
 // This type declaration needs to match AllocatorSelector in mmtk-core
 struct AllocatorSelector {
@@ -94,6 +95,7 @@ extern size_t get_max_non_los_default_alloc_bytes();
  */
 extern void add_finalizer(void* obj);
 extern void* get_finalized_object();
+extern size_t get_finalized_objects(void** buf, size_t capacity);
 
 /**
  * Misc
@@ -119,6 +121,9 @@ extern size_t mmtk_unregister_nmethod(void* nm);
  */
 extern size_t free_bytes();
 extern size_t total_bytes();
+extern size_t mmtk_get_space_count();
+extern size_t mmtk_get_space_name(size_t index, char* buf, size_t len);
+extern bool mmtk_get_space_usage(size_t index, size_t* used, size_t* committed);
 
 typedef struct {
     void** buf;
@@ -147,12 +152,13 @@ struct SlotsClosure {
  * OpenJDK-specific
  */
 typedef struct {
-    void (*stop_all_mutators) (void *tls, MutatorClosure closure);
+    void (*stop_all_mutators) (void *tls);
     void (*resume_mutators) (void *tls);
     void (*spawn_gc_thread) (void *tls, int kind, void *ctx);
     void (*block_for_gc) ();
     void (*out_of_memory) (void *tls, MMTkAllocationError err_kind);
-    void (*get_mutators) (MutatorClosure closure);
+    MMTk_Mutator* (*get_mutators) (size_t* len);
+    void (*get_live_mutators) (MutatorClosure closure);
     void (*scan_object) (void* trace, void* object, void* tls);
     void (*dump_object) (void* object);
     size_t (*get_object_size) (void* object);
@@ -165,8 +171,8 @@ typedef struct {
     int (*static_oop_field_count_offset) ();
     int (*referent_offset) ();
     int (*discovered_offset) ();
+    int (*soft_reference_timestamp_offset) ();
     char* (*dump_object_string) (void* object);
-    void (*scan_roots_in_all_mutator_threads)(SlotsClosure closure);
     void (*scan_roots_in_mutator_thread)(SlotsClosure closure, void* tls);
     void (*scan_universe_roots) (SlotsClosure closure);
     void (*scan_jni_handle_roots) (SlotsClosure closure);
@@ -177,7 +183,7 @@ typedef struct {
     void (*scan_system_dictionary_roots) (SlotsClosure closure);
     void (*scan_code_cache_roots) (SlotsClosure closure);
     void (*scan_string_table_roots) (SlotsClosure closure);
-    void (*scan_class_loader_data_graph_roots) (SlotsClosure closure);
+    void (*scan_class_loader_data_graph_roots) (SlotsClosure closure, bool scan_all);
     void (*scan_weak_processor_roots) (SlotsClosure closure);
     void (*scan_vm_thread_roots) (SlotsClosure closure);
     size_t (*number_of_mutators)();
@@ -197,6 +203,17 @@ extern size_t mmtk_narrow_oop_shift();
 extern size_t mmtk_set_compressed_klass_base_and_shift(void* base, size_t shift);
 
 extern size_t used_bytes();
+extern bool mmtk_is_generational();
+extern bool mmtk_is_concurrent();
+extern bool mmtk_is_current_gc_nursery();
+extern bool mmtk_is_emergency_collection();
+extern void mmtk_set_allocation_reserve_bytes(size_t bytes);
+
+/**
+ * USDT probes fired from C++
+ */
+extern void mmtk_probe_stw_request(int state);
+extern void mmtk_probe_stw_reached(int state);
 extern void* starting_heap_address();
 extern void* last_heap_address();
 extern void iterator(); // ???
@@ -215,6 +232,7 @@ extern bool   executable();
 extern void add_weak_candidate(void* ref, void* referent);
 extern void add_soft_candidate(void* ref, void* referent);
 extern void add_phantom_candidate(void* ref, void* referent);
+extern void mmtk_set_soft_reference_policy(int64_t clock, int64_t max_interval);
 
 extern void mmtk_harness_begin_impl();
 extern void mmtk_harness_end_impl();
@@ -130,13 +130,8 @@ void MMTkBarrierSetAssembler::eden_allocate(MacroAssembler* masm, Register threa
     __ movb(Address(rcx, tmp3), tmp2);
   }
 
-    // BarrierSetAssembler::incr_allocated_bytes
-    if (var_size_in_bytes->is_valid()) {
-      __ addq(Address(r15_thread, in_bytes(JavaThread::allocated_bytes_offset())), var_size_in_bytes);
-    } else {
-      __ addq(Address(r15_thread, in_bytes(JavaThread::allocated_bytes_offset())), con_size_in_bytes);
-    }
-    __ addq(Address(r15_thread, in_bytes(JavaThread::allocated_bytes_offset())), extra_header);
+    // Unlike BarrierSetAssembler::eden_allocate, we do not update allocated_bytes here. The
+    // thread is charged for the whole bump region in the slow path. See MMTkMutatorContext::alloc.
   }
 }
 
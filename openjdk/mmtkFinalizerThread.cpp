@@ -23,12 +23,18 @@
  */
 
 #include "precompiled.hpp"
+#include "jvm.h"
 #include "classfile/stringTable.hpp"
-#include "classfile/symbolTable.hpp"
+#include "classfile/systemDictionary.hpp"
+#include "classfile/vmSymbols.hpp"
 #include "mmtk.h"
 #include "mmtkFinalizerThread.hpp"
+#include "oops/instanceKlass.hpp"
+#include "oops/klassVtable.hpp"
+#include "oops/method.hpp"
 #include "oops/oop.inline.hpp"
 #include "prims/jvmtiImpl.hpp"
+#include "runtime/handles.inline.hpp"
 #include "runtime/interfaceSupport.inline.hpp"
 #include "runtime/javaCalls.hpp"
 #include "runtime/mutex.hpp"
@@ -40,14 +46,37 @@
 #include "services/gcNotifier.hpp"
 #include "services/lowMemoryDetector.hpp"
 
-MMTkFinalizerThread* MMTkFinalizerThread::instance = NULL;
+size_t MMTkFinalizerThread::num_threads = 1;
+MMTkFinalizerThread** MMTkFinalizerThread::threads = NULL;
+int MMTkFinalizerThread::finalize_vtable_index = Method::invalid_vtable_index;
 
 void MMTkFinalizerThread::initialize() {
   EXCEPTION_MARK;
 
+  assert(num_threads > 0, "checked when MMTK_FINALIZER_THREADS is read");
+
+  // Subclasses override finalize() through the vtable, as an invokevirtual of Object.finalize()
+  // in java.lang.ref.Finalizer would see them.
+  Method* finalize = SystemDictionary::Object_klass()->find_method(vmSymbols::finalize_method_name(),
+                                                                   vmSymbols::void_method_signature());
+  guarantee(finalize != NULL && finalize->has_vtable_index(), "java.lang.Object.finalize() must be virtual");
+  finalize_vtable_index = finalize->vtable_index();
+
+  threads = NEW_C_HEAP_ARRAY(MMTkFinalizerThread*, num_threads, mtGC);
+  for (size_t i = 0; i < num_threads; i++) {
+    create_thread(i, CHECK);
+  }
+}
+
+void MMTkFinalizerThread::create_thread(size_t index, TRAPS) {
   HandleMark hm;
 
-  const char* name = "MMTk Finalizer Thread";
+  char name[64];
+  if (num_threads == 1) {
+    jio_snprintf(name, sizeof(name), "MMTk Finalizer Thread");
+  } else {
+    jio_snprintf(name, sizeof(name), "MMTk Finalizer Thread#" SIZE_FORMAT, index);
+  }
   Handle string = java_lang_String::create_from_str(name, CHECK);
 
   // Initialize thread_oop to put it into the system threadGroup
@@ -60,7 +89,7 @@ void MMTkFinalizerThread::initialize() {
 
   {
     MutexLocker mu(Threads_lock);
-    MMTkFinalizerThread* thread =  new MMTkFinalizerThread(&finalizer_thread_entry);
+    MMTkFinalizerThread* thread =  new MMTkFinalizerThread(&finalizer_thread_entry, index);
 
     // At this point it may be possible that no osthread was created for the
     // JavaThread due to lack of memory. We would have to throw an exception
@@ -75,7 +104,7 @@ void MMTkFinalizerThread::initialize() {
     java_lang_Thread::set_priority(thread_oop(), NearMaxPriority);
     java_lang_Thread::set_daemon(thread_oop());
     thread->set_threadObj(thread_oop());
-    instance = thread;
+    threads[index] = thread;
 
     Threads::add(thread);
     Thread::start(thread);
@@ -83,7 +112,7 @@ void MMTkFinalizerThread::initialize() {
 }
 
 void MMTkFinalizerThread::finalizer_thread_entry(JavaThread* thread, TRAPS) {
-  MMTkFinalizerThread* this_thread = MMTkFinalizerThread::instance;
+  MMTkFinalizerThread* this_thread = (MMTkFinalizerThread*) thread;
   while (true) {
     // Wait until scheduled
     {
@@ -96,35 +125,54 @@ void MMTkFinalizerThread::finalizer_thread_entry(JavaThread* thread, TRAPS) {
     }
 
     // finalize objects
-    while (true) {
-      void* obj_ref = get_finalized_object();
-      if (obj_ref != NULL) {
-        instanceOop obj = (instanceOop) obj_ref;
-
-        // Invoke finalize()
-        {
-          HandleMark hm;
-          JavaValue ret(T_VOID);
-          instanceHandle handle_obj(this_thread, obj);
-          TempNewSymbol finalize_method = SymbolTable::new_symbol("finalize", this_thread);
-          Symbol* sig = vmSymbols::void_method_signature();
-
-          JavaCalls::call_virtual(&ret, handle_obj, obj->klass(), finalize_method, sig, this_thread);
-        }
-      } else {
-        break;
-      }
-    }
+    while (this_thread->finalize_batch(THREAD) > 0) {}
   }
 }
 
-MMTkFinalizerThread::MMTkFinalizerThread(ThreadFunction entry_point) : JavaThread(entry_point) {
+size_t MMTkFinalizerThread::finalize_batch(TRAPS) {
+  void* objs[FINALIZE_BATCH_SIZE];
+  size_t count = get_finalized_objects(objs, FINALIZE_BATCH_SIZE);
+  if (count == 0) {
+    return 0;
+  }
+  if (count == FINALIZE_BATCH_SIZE && _index + 1 < num_threads) {
+    // There may be more.  Let the next thread help before running any finalizer, so that a slow
+    // finalize() here does not hold the rest of the queue back.
+    threads[_index + 1]->schedule();
+  }
+
+  HandleMark hm(THREAD);
+  // The objects are only reachable from `objs` now. Make them roots before the first Java call
+  // may let a GC in.
+  instanceHandle handles[FINALIZE_BATCH_SIZE];
+  for (size_t i = 0; i < count; i++) {
+    handles[i] = instanceHandle(THREAD, (instanceOop) objs[i]);
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    // The vtable holds the finalize() each class resolves to, so no lookup is needed.
+    methodHandle finalize_method(THREAD, handles[i]->klass()->method_at_vtable(finalize_vtable_index));
+
+    JavaValue ret(T_VOID);
+    JavaCallArguments args(handles[i]);
+    JavaCalls::call(&ret, finalize_method, &args, THREAD);
+    // Like java.lang.ref.Finalizer, ignore whatever finalize() throws.
+    CLEAR_PENDING_EXCEPTION;
+  }
+  return count;
+}
+
+MMTkFinalizerThread::MMTkFinalizerThread(ThreadFunction entry_point, size_t index) : JavaThread(entry_point), _index(index) {
   this->is_scheduled = false;
   this->m = new Monitor(Mutex::suspend_resume, "mmtk-finalizer-monitor", true, Monitor::_safepoint_check_never);
 }
 
-void MMTkFinalizerThread::schedule() {
+void MMTkFinalizerThread::schedule_all() {
   assert(!Thread::current()->is_Java_thread(), "Supposed to be called by GC thread. Actually called by JavaThread.");
+  threads[0]->schedule();
+}
+
+void MMTkFinalizerThread::schedule() {
   MutexLockerEx mu(this->m, Mutex::_no_safepoint_check_flag);
   if (!this->is_scheduled) {
     this->is_scheduled = true;
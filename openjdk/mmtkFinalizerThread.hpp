@@ -31,23 +31,51 @@
 
 // This mimics the example of hotspot/share/runtime/ServiceThread.hpp
 
+// A pool of `num_threads` finalizer threads. They all pull batches of objects from the queue of
+// finalizable objects in MMTk, so a backlog of finalizers is worked off in parallel. MMTk's queue
+// is guarded by a mutex that get_finalized_objects takes once per object, so the threads still
+// contend on it while they fill their batches; the parallelism is in running the finalizers.
 class MMTkFinalizerThread: public JavaThread {
 private:
+  // Index of this thread in `threads`.
+  size_t _index;
+
   // Constructor
-  MMTkFinalizerThread(ThreadFunction entry_point);
+  MMTkFinalizerThread(ThreadFunction entry_point, size_t index);
+
+  static void create_thread(size_t index, TRAPS);
 
   // No destruction allowed
   ~MMTkFinalizerThread() {
     guarantee(false, "VMThread deletion must fix the race with VM termination");
   }
+
+  // The vtable index of java.lang.Object.finalize().
+  static int finalize_vtable_index;
+
+  // The maximum number of objects taken from MMTk at a time.
+  static const size_t FINALIZE_BATCH_SIZE = 256;
+
+  // Finalize a batch of objects that MMTk found ready for finalization. Returns the number of
+  // objects finalized, or 0 if there are none left. Wakes the next thread up if the batch is full.
+  size_t finalize_batch(TRAPS);
+
+  // Wake this thread up if it is waiting for work.
+  void schedule();
 public:
   bool is_scheduled;
   Monitor* m;
-  static MMTkFinalizerThread* instance;
+  // The number of finalizer threads, which can be set with the MMTK_FINALIZER_THREADS environment
+  // variable. Defaults to 1.
+  static size_t num_threads;
+  static MMTkFinalizerThread** threads;
   static void initialize();
   static void finalizer_thread_entry(JavaThread* thread, TRAPS);
 
-  void schedule();
+  // Called by GC threads when there are new objects to finalize. Wakes up the first finalizer
+  // thread. A thread that finds a full batch wakes the next one, so more threads join in only
+  // when there is a backlog.
+  static void schedule_all();
 };
 
 #endif // MMTK_OPENJDK_MMTK_FINALIZER_THREAD_HPP
@@ -24,15 +24,22 @@
 
 #include "precompiled.hpp"
 #include "aot/aotLoader.hpp"
+#include "classfile/classLoaderData.hpp"
+#include "classfile/javaClasses.inline.hpp"
 #include "classfile/stringTable.hpp"
 #include "code/codeCache.hpp"
+#include "gc/shared/allocTracer.hpp"
 #include "gc/shared/gcHeapSummary.hpp"
 #include "gc/shared/gcLocker.inline.hpp"
+#include "gc/shared/gcName.hpp"
 #include "gc/shared/gcWhen.hpp"
+#include "gc/shared/oopStorageParState.inline.hpp"
 #include "gc/shared/strongRootsScope.hpp"
 #include "gc/shared/weakProcessor.hpp"
+#include "jfr/jfrEvents.hpp"
 #include "logging/log.hpp"
 #include "memory/resourceArea.hpp"
+#include "memory/universe.hpp"
 #include "mmtk.h"
 #include "mmtkHeap.hpp"
 #include "mmtkMutator.hpp"
@@ -41,11 +48,16 @@
 #include "oops/oop.inline.hpp"
 #include "runtime/atomic.hpp"
 #include "runtime/handles.inline.hpp"
+#include "runtime/handshake.hpp"
 #include "runtime/java.hpp"
+#include "runtime/mutexLocker.hpp"
+#include "runtime/safepoint.hpp"
 #include "runtime/thread.hpp"
+#include "runtime/threadSMR.hpp"
 #include "runtime/vmThread.hpp"
 #include "services/management.hpp"
 #include "services/memoryManager.hpp"
+#include "services/memoryService.hpp"
 #include "services/memTracker.hpp"
 #include "utilities/vmError.hpp"
 /*
@@ -62,6 +74,7 @@ object iterator??!!
 
 
 MMTkHeap* MMTkHeap::_heap = NULL;
+size_t MMTkHeap::_allocation_sample_bytes = 0;
 
 MMTkHeap::MMTkHeap(MMTkCollectorPolicy* policy) :
   CollectedHeap(),
@@ -69,10 +82,31 @@ MMTkHeap::MMTkHeap(MMTkCollectorPolicy* policy) :
   _collector_policy(policy),
   _num_root_scan_tasks(0),
   _n_workers(0),
+  _string_table_par_state(NULL),
+  _mutators(NULL),
+  _num_mutators(0),
+  _mutators_capacity(0),
+  _mutators_valid(false),
+  _used_after_last_gc(0),
+  _mmtk_pools(NULL),
+  _num_mmtk_pools(0),
+  _nursery_manager(NULL),
+  _full_manager(NULL),
+  _concurrent_manager(NULL),
+  _pause_manager(NULL),
+  _in_concurrent_cycle(false),
+  _gc_id(0),
+  _pending_references(NULL),
+  _pending_references_tail(NULL),
+#ifndef LINUX
   _gc_lock(new Monitor(Mutex::safepoint, "MMTkHeap::_gc_lock", true, Monitor::_safepoint_check_never)),
+#endif
   _soft_ref_policy()
 {
   _heap = this;
+  for (int i = 0; i <= REF_PHANTOM; i++) {
+    _enqueued_references[i] = 0;
+  }
 }
 
 static void set_bool_option_from_env_var(const char *name, bool *var) {
@@ -89,11 +123,34 @@ static void set_bool_option_from_env_var(const char *name, bool *var) {
   }
 }
 
+static void set_size_option_from_env_var(const char *name, size_t *var) {
+  const char *env_var = getenv(name);
+  if (env_var != NULL) {
+    char *end;
+    unsigned long long value = strtoull(env_var, &end, 10);
+    if (*env_var == '\0' || *end != '\0') {
+      fprintf(stderr, "Unexpected value for env var %s: %s\n", name, env_var);
+      abort();
+    }
+    *var = (size_t) value;
+  }
+}
+
 jint MMTkHeap::initialize() {
   assert(!UseTLAB , "should disable UseTLAB");
 
   set_bool_option_from_env_var("MMTK_ENABLE_ALLOCATION_FASTPATH", &mmtk_enable_allocation_fastpath);
   set_bool_option_from_env_var("MMTK_ENABLE_BARRIER_FASTPATH", &mmtk_enable_barrier_fastpath);
+  set_bool_option_from_env_var("MMTK_DIRECT_STW", &MMTkVMCompanionThread::direct_stw);
+  set_size_option_from_env_var("MMTK_FLUSH_MUTATORS_INTERVAL_MS", &MMTkVMCompanionThread::flush_mutators_interval_ms);
+  set_size_option_from_env_var("MMTK_FINALIZER_THREADS", &MMTkFinalizerThread::num_threads);
+  if (MMTkFinalizerThread::num_threads == 0) {
+    vm_exit_during_initialization("MMTK_FINALIZER_THREADS must be at least 1");
+  }
+  set_size_option_from_env_var("MMTK_ALLOCATION_SAMPLE_BYTES", &_allocation_sample_bytes);
+  size_t allocation_reserve_bytes = 0;
+  set_size_option_from_env_var("MMTK_ALLOCATION_RESERVE_BYTES", &allocation_reserve_bytes);
+  mmtk_set_allocation_reserve_bytes(allocation_reserve_bytes);
 
   const size_t min_heap_size = collector_policy()->min_heap_byte_size();
   const size_t max_heap_size = collector_policy()->max_heap_byte_size();
@@ -161,11 +218,13 @@ jint MMTkHeap::initialize() {
   BarrierSet::set_barrier_set(barrier_set);
 
   _companion_thread = new MMTkVMCompanionThread();
-  if (!os::create_thread(_companion_thread, os::pgc_thread)) {
-    fprintf(stderr, "Failed to create thread");
-    guarantee(false, "panic");
+  if (!MMTkVMCompanionThread::direct_stw || MMTkVMCompanionThread::flush_mutators_interval_ms != 0) {
+    if (!os::create_thread(_companion_thread, os::pgc_thread)) {
+      fprintf(stderr, "Failed to create thread");
+      guarantee(false, "panic");
+    }
+    os::start_thread(_companion_thread);
   }
-  os::start_thread(_companion_thread);
   // Set up the GCTaskManager
   //  _mmtk_gc_task_manager = mmtkGCTaskManager::create(ParallelGCThreads);
   return JNI_OK;
@@ -190,7 +249,7 @@ const char* MMTkHeap::version() {
 }
 
 void MMTkHeap::schedule_finalizer() {
-  MMTkFinalizerThread::instance->schedule();
+  MMTkFinalizerThread::schedule_all();
 }
 
 void MMTkHeap::post_initialize() {
@@ -320,26 +379,49 @@ SoftRefPolicy* MMTkHeap::soft_ref_policy() {return &_soft_ref_policy;}//OK
 
 GrowableArray<GCMemoryManager*> MMTkHeap::memory_managers() {//may cause error
 
-  GrowableArray<GCMemoryManager*> memory_managers(1);
-  memory_managers.append(_mmtk_manager);
+  GrowableArray<GCMemoryManager*> memory_managers(3);
+  if (_nursery_manager != NULL) {
+    memory_managers.append(_nursery_manager);
+  }
+  memory_managers.append(_full_manager);
+  if (_concurrent_manager != NULL) {
+    memory_managers.append(_concurrent_manager);
+  }
   return memory_managers;
 }
 GrowableArray<MemoryPool*> MMTkHeap::memory_pools() {//may cause error
 
-  GrowableArray<MemoryPool*> memory_pools(1);
-  memory_pools.append(_mmtk_pool);
+  GrowableArray<MemoryPool*> memory_pools((int) _num_mmtk_pools);
+  for (size_t i = 0; i < _num_mmtk_pools; i++) {
+    memory_pools.append(_mmtk_pools[i]);
+  }
   return memory_pools;
 }
 
 // Iterate over all objects, calling "cl.do_object" on each.
-void MMTkHeap::object_iterate(ObjectClosure* cl) { //No need to implement.Traced whole path.Only other heaps call it.
-  fprintf(stderr, "WARNING: MMTkHeap::object_iterate is not implemented, yet.\n");
+#ifdef MMTK_ENABLE_VO_BIT
+static void object_iterate_visitor(void* object, void* data) {
+  ((ObjectClosure*) data)->do_object((oop) object);
+}
+#endif
+
+// Used by heap inspection (jmap -histo), heap dumps and JVMTI heap iteration, all of which run at a
+// safepoint. MMTk finds objects with the VO bits, which are only maintained if the binding is
+// built with MMTK_VO_BIT=1.
+void MMTkHeap::object_iterate(ObjectClosure* cl) {
+  assert(SafepointSynchronize::is_at_safepoint(), "must be at safepoint");
+#ifdef MMTK_ENABLE_VO_BIT
+  mmtk_enumerate_objects(&object_iterate_visitor, cl);
+#else
+  fprintf(stderr, "WARNING: MMTkHeap::object_iterate requires building with MMTK_VO_BIT=1.\n");
+#endif
 }
 
 // Similar to object_iterate() except iterates only
 // over live objects.
-void MMTkHeap::safe_object_iterate(ObjectClosure* cl) { //not sure..many dependencies from vm
-  fprintf(stderr, "WARNING: MMTkHeap::safe_object_iterate is not implemented, yet.\n");
+void MMTkHeap::safe_object_iterate(ObjectClosure* cl) {
+  // Every object MMTk enumerates is parsable, so this is the same as object_iterate().
+  object_iterate(cl);
 }
 
 HeapWord* MMTkHeap::block_start(const void* addr) const {//OK
@@ -376,10 +458,37 @@ void MMTkHeap::prepare_for_verify() {
 void MMTkHeap::initialize_serviceability() {//OK
 
 
-  _mmtk_pool = new MMTkMemoryPool(_start, _end,  "MMTk pool",collector_policy()->min_heap_byte_size(), false);
+  // Each space may grow up to the whole heap, so every pool reports the heap size as its maximum.
+  _num_mmtk_pools = mmtk_get_space_count();
+  _mmtk_pools = NEW_C_HEAP_ARRAY(MMTkMemoryPool*, _num_mmtk_pools, mtGC);
+  for (size_t i = 0; i < _num_mmtk_pools; i++) {
+    char space_name[64];
+    mmtk_get_space_name(i, space_name, sizeof(space_name));
+    size_t len = strlen("MMTk ") + strlen(space_name) + 1;
+    char* pool_name = NEW_C_HEAP_ARRAY(char, len, mtGC);
+    jio_snprintf(pool_name, len, "MMTk %s", space_name);
+    _mmtk_pools[i] = new MMTkMemoryPool(i, pool_name, max_capacity(), true);
+  }
 
-  _mmtk_manager = new GCMemoryManager("MMTk GC", "end of GC");
-  _mmtk_manager->add_pool(_mmtk_pool);
+  if (mmtk_is_generational()) {
+    _nursery_manager = new GCMemoryManager("MMTk Nursery GC", "end of minor GC");
+  }
+  if (mmtk_is_concurrent()) {
+    _full_manager = new GCMemoryManager("MMTk Pauses", "end of GC pause");
+    _concurrent_manager = new GCMemoryManager("MMTk Cycles", "end of GC cycle");
+  } else {
+    _full_manager = new GCMemoryManager("MMTk Full GC", "end of major GC");
+  }
+
+  for (size_t i = 0; i < _num_mmtk_pools; i++) {
+    if (_nursery_manager != NULL) {
+      _nursery_manager->add_pool(_mmtk_pools[i]);
+    }
+    _full_manager->add_pool(_mmtk_pools[i]);
+    if (_concurrent_manager != NULL) {
+      _concurrent_manager->add_pool(_mmtk_pools[i]);
+    }
+  }
 }
 
 // Print heap information on the given outputStream.
@@ -461,10 +570,33 @@ void MMTkHeap::scan_code_cache_roots(OopClosure& cl) {
   CodeCache::blobs_do(&cb_cl);
 }
 void MMTkHeap::scan_string_table_roots(OopClosure& cl) {
-  StringTable::oops_do(&cl);
+  // Several packets call this concurrently. Each claims blocks of the string table from the
+  // shared ParState until none are left.
+  if (_string_table_par_state != NULL) {
+    StringTable::possibly_parallel_oops_do(_string_table_par_state, &cl);
+  } else {
+    StringTable::oops_do(&cl);
+  }
 }
-void MMTkHeap::scan_class_loader_data_graph_roots(OopClosure& cl) {
-  CLDToOopClosure cld_cl(&cl, false);
+// Visits the oops of class loader data.  Each CLD records whether it has gained new oops (handles
+// added for mirrors, resolved strings, etc.) since its oops were last visited, which works as a
+// remembered set: a CLD that has not been modified since the last GC only points to objects that
+// survived that GC, which are mature by now.  Nursery GCs therefore only visit modified CLDs.
+class MMTkCLDScanClosure : public CLDClosure {
+  OopClosure* _cl;
+  bool _scan_all;
+public:
+  MMTkCLDScanClosure(OopClosure* cl, bool scan_all) : _cl(cl), _scan_all(scan_all) {}
+
+  void do_cld(ClassLoaderData* cld) {
+    if (_scan_all || cld->has_modified_oops()) {
+      cld->oops_do(_cl, false, /* clear_modified_oops */ true);
+    }
+  }
+};
+
+void MMTkHeap::scan_class_loader_data_graph_roots(OopClosure& cl, bool scan_all) {
+  MMTkCLDScanClosure cld_cl(&cl, scan_all);
   ClassLoaderDataGraph::cld_do(&cld_cl);
 }
 void MMTkHeap::scan_weak_processor_roots(OopClosure& cl) {
@@ -476,9 +608,197 @@ void MMTkHeap::scan_vm_thread_roots(OopClosure& cl) {
   VMThread::vm_thread()->oops_do(&cl, NULL);
 }
 
-void MMTkHeap::scan_roots_in_all_mutator_threads(OopClosure& cl) {
-  ResourceMark rm;
-  Threads::possibly_parallel_oops_do(false, &cl, NULL);
+void MMTkHeap::prepare_parallel_root_scanning() {
+  assert(SafepointSynchronize::is_at_safepoint(), "must be at safepoint");
+  finish_parallel_root_scanning();
+  _string_table_par_state = new OopStorage::ParState<false, false>(StringTable::weak_storage());
+}
+
+void MMTkHeap::finish_parallel_root_scanning() {
+  if (_string_table_par_state != NULL) {
+    delete _string_table_par_state;
+    _string_table_par_state = NULL;
+  }
+}
+
+void MMTkHeap::snapshot_mutators() {
+  assert(SafepointSynchronize::is_at_safepoint(), "must be at safepoint");
+  // Threads cannot start or exit at a safepoint, so the snapshot stays valid until the mutators
+  // resume.
+  JavaThreadIteratorWithHandle jtiwh;
+  size_t length = (size_t) jtiwh.length();
+  if (_mutators == NULL || length > _mutators_capacity) {
+    FREE_C_HEAP_ARRAY(MMTkMutatorContext*, _mutators);
+    _mutators_capacity = MAX2(length, _mutators_capacity * 2);
+    _mutators = NEW_C_HEAP_ARRAY(MMTkMutatorContext*, _mutators_capacity, mtGC);
+  }
+  _num_mutators = 0;
+  while (JavaThread* cur = jtiwh.next()) {
+    _mutators[_num_mutators++] = &cur->third_party_heap_mutator;
+  }
+  _mutators_valid = true;
+}
+
+// Runs in the target thread, or in the VM thread while the target thread is blocked, so the
+// allocation fast paths are not using the mutator.
+class MMTkFlushMutatorClosure : public ThreadClosure {
+public:
+  virtual void do_thread(Thread* thread) {
+    MMTkMutatorContext* mutator = &thread->third_party_heap_mutator;
+    // Flushing may retire the bump region.  Keep allocated_bytes in step with the region the
+    // thread is left with, as mmtk_stop_all_mutators and mmtk_resume_mutators do.
+    mutator->refund_fastpath_bytes();
+    mutator->flush();
+    mutator->charge_fastpath_bytes();
+  }
+};
+
+void MMTkHeap::flush_mutators() {
+  assert(!Thread::current()->is_VM_thread(), "the VM thread cannot wait for a handshake");
+  MMTkFlushMutatorClosure cl;
+  Handshake::execute(&cl);
+  log_debug(gc)("Flushed all mutators by handshake.");
+}
+
+void MMTkHeap::prepare_soft_reference_policy() {
+  jlong clock = java_lang_ref_SoftReference::clock();
+  jlong max_interval;
+  if (_soft_ref_policy.should_clear_all_soft_refs() || mmtk_is_emergency_collection()) {
+    // Every timestamp is at or before the clock, so this clears all soft references.  An
+    // emergency GC is the last attempt before an OutOfMemoryError, and all soft references must
+    // be cleared before one is thrown.
+    max_interval = -1;
+  } else {
+    // Like LRUMaxHeapPolicy, use the heap occupancy after the previous GC.  The occupancy now is
+    // close to full, as the heap is collected when it fills up.
+    size_t used_bytes = MIN2(_used_after_last_gc, max_capacity());
+    max_interval = (jlong) ((max_capacity() - used_bytes) / M) * SoftRefLRUPolicyMSPerMB;
+  }
+  log_trace(gc, ref)("Soft reference policy: clock = " JLONG_FORMAT ", max interval = " JLONG_FORMAT " ms", clock, max_interval);
+  mmtk_set_soft_reference_policy(clock, max_interval);
+}
+
+void MMTkHeap::update_soft_reference_clock() {
+  _used_after_last_gc = used();
+  if (_soft_ref_policy.should_clear_all_soft_refs()) {
+    _soft_ref_policy.cleared_all_soft_refs();
+  }
+  jlong now = os::javaTimeNanos() / NANOSECS_PER_MILLISEC;
+  // Like ReferenceProcessor::update_soft_ref_master_clock, never move the clock backwards.
+  if (now > java_lang_ref_SoftReference::clock()) {
+    java_lang_ref_SoftReference::set_clock(now);
+  }
+}
+
+void MMTkHeap::report_pause_begin(const Ticks& pause_start) {
+  assert(_pause_manager == NULL, "pauses do not nest");
+  _pause_start = pause_start;
+  _pause_manager = mmtk_is_current_gc_nursery() ? _nursery_manager : _full_manager;
+  MemoryService::gc_begin(_pause_manager, true /* recordGCBeginTime */, true /* recordAccumulatedGCTime */,
+                          true /* recordPreGCUsage */, true /* recordPeakUsage */);
+}
+
+void MMTkHeap::report_pause_end() {
+  assert(_pause_manager != NULL, "not in a pause");
+  Ticks pause_end = Ticks::now();
+  Tickspan pause = pause_end - _pause_start;
+  const char* pause_name = _pause_manager == _nursery_manager ? "Pause Nursery"
+                         : _concurrent_manager != NULL ? "Pause" : "Pause Full";
+
+  EventGCPhasePause phase_event(UNTIMED);
+  if (phase_event.should_commit()) {
+    phase_event.set_gcId(_gc_id);
+    phase_event.set_name(pause_name);
+    phase_event.set_starttime(_pause_start);
+    phase_event.set_endtime(pause_end);
+    phase_event.commit();
+  }
+
+  for (int type = REF_SOFT; type <= REF_PHANTOM; type++) {
+    size_t count = _enqueued_references[type];
+    _enqueued_references[type] = 0;
+    EventGCReferenceStatistics ref_event;
+    if (ref_event.should_commit()) {
+      ref_event.set_gcId(_gc_id);
+      ref_event.set_type((u1) type);
+      ref_event.set_count(count);
+      ref_event.commit();
+    }
+  }
+
+  // There is no GCName for MMTk.  Each pause is reported as one collection.
+  EventGarbageCollection gc_event(UNTIMED);
+  if (gc_event.should_commit()) {
+    gc_event.set_gcId(_gc_id);
+    gc_event.set_name(NA);
+    gc_event.set_cause((u2) GCCause::_no_cause_specified);
+    gc_event.set_sumOfPauses(pause);
+    gc_event.set_longestPause(pause);
+    gc_event.set_starttime(_pause_start);
+    gc_event.set_endtime(pause_end);
+    gc_event.commit();
+  }
+  _gc_id++;
+
+  // MMTk does not tell us what triggered the GC.
+  MemoryService::gc_end(_pause_manager, true /* recordPostGCUsage */, true /* recordAccumulatedGCTime */,
+                        true /* recordGCEndTime */, true /* countCollection */, GCCause::_no_cause_specified,
+                        true /* allMemoryPoolsAffected */);
+  _pause_manager = NULL;
+
+  if (_concurrent_manager != NULL) {
+    // Set by the binding before resuming the mutators.
+    bool concurrent_work_active = CONCURRENT_MARKING_ACTIVE != 0;
+    if (concurrent_work_active && !_in_concurrent_cycle) {
+      MemoryService::gc_begin(_concurrent_manager, true /* recordGCBeginTime */, true /* recordAccumulatedGCTime */,
+                              true /* recordPreGCUsage */, true /* recordPeakUsage */);
+      _in_concurrent_cycle = true;
+    } else if (!concurrent_work_active && _in_concurrent_cycle) {
+      MemoryService::gc_end(_concurrent_manager, true /* recordPostGCUsage */, true /* recordAccumulatedGCTime */,
+                            true /* recordGCEndTime */, true /* countCollection */, GCCause::_no_cause_specified,
+                            true /* allMemoryPoolsAffected */);
+      _in_concurrent_cycle = false;
+    }
+  }
+}
+
+void MMTkHeap::send_phase_event(const char* name, const Ticks& start, const Ticks& end) {
+  EventGCPhasePauseLevel1 event(UNTIMED);
+  if (event.should_commit()) {
+    event.set_gcId(_gc_id);
+    event.set_name(name);
+    event.set_starttime(start);
+    event.set_endtime(end);
+    event.commit();
+  }
+}
+
+void MMTkHeap::record_enqueued_references(const size_t* counts) {
+  for (int type = REF_SOFT; type <= REF_PHANTOM; type++) {
+    if (counts[type] != 0) {
+      Atomic::add(counts[type], &_enqueued_references[type]);
+    }
+  }
+}
+
+oop MMTkHeap::swap_pending_references(oop first, oop last) {
+  oop old_first = Atomic::xchg(first, &_pending_references);
+  if (old_first == NULL) {
+    // Only the first worker to splice sees an empty list, so its last reference ends the list.
+    _pending_references_tail = last;
+  }
+  return old_first;
+}
+
+void MMTkHeap::publish_pending_references() {
+  assert(Heap_lock->owned_by_self(), "Reference pending list access requires lock");
+  if (_pending_references == NULL) {
+    return;
+  }
+  oop old_first = Universe::swap_reference_pending_list(_pending_references);
+  HeapAccess<AS_RAW>::oop_store_at(_pending_references_tail, java_lang_ref_Reference::discovered_offset, old_first);
+  _pending_references = NULL;
+  _pending_references_tail = NULL;
 }
 
 void MMTkHeap::scan_roots(OopClosure& cl) {
@@ -525,6 +845,51 @@ HeapWord* MMTkHeap::mem_allocate_nonmove(size_t size, bool* gc_overhead_limit_wa
   return Thread::current()->third_party_heap_mutator.alloc(size << LogHeapWordSize, AllocatorLos);
 }
 
+oop MMTkHeap::obj_allocate(Klass* klass, int size, TRAPS) {
+  size_t remaining_before = THREAD->third_party_heap_mutator.fastpath_bytes_remaining();
+  jlong allocated_before = THREAD->allocated_bytes();
+  oop obj = CollectedHeap::obj_allocate(klass, size, CHECK_NULL);
+  sample_allocation(THREAD, klass, obj, size, remaining_before, allocated_before);
+  return obj;
+}
+
+oop MMTkHeap::array_allocate(Klass* klass, int size, int length, bool do_zero, TRAPS) {
+  size_t remaining_before = THREAD->third_party_heap_mutator.fastpath_bytes_remaining();
+  jlong allocated_before = THREAD->allocated_bytes();
+  oop obj = CollectedHeap::array_allocate(klass, size, length, do_zero, CHECK_NULL);
+  sample_allocation(THREAD, klass, obj, size, remaining_before, allocated_before);
+  return obj;
+}
+
+oop MMTkHeap::class_allocate(Klass* klass, int size, TRAPS) {
+  size_t remaining_before = THREAD->third_party_heap_mutator.fastpath_bytes_remaining();
+  jlong allocated_before = THREAD->allocated_bytes();
+  oop obj = CollectedHeap::class_allocate(klass, size, CHECK_NULL);
+  sample_allocation(THREAD, klass, obj, size, remaining_before, allocated_before);
+  return obj;
+}
+
+void MMTkHeap::sample_allocation(Thread* thread, Klass* klass, oop obj, int size, size_t remaining_before, jlong allocated_before) {
+  size_t alloc_size = (size_t) size * HeapWordSize;
+  size_t remaining_after = thread->third_party_heap_mutator.fastpath_bytes_remaining();
+  if (alloc_size >= MMTkMutatorContext::max_non_los_default_alloc_bytes || remaining_after == 0 ||
+      remaining_after + alloc_size == remaining_before) {
+    // Not a refill.  Either the object went to a space without a bump region, which MemAllocator
+    // has already reported as ObjectAllocationOutsideTLAB, or it was bump-allocated from the old
+    // region, which is like an allocation in the current TLAB.
+    return;
+  }
+
+  // The slow path charges allocated_bytes a whole bump region at a time (see
+  // MMTkMutatorContext::alloc), so a sample is taken at most once per refill.
+  julong allocated_after = (julong) thread->allocated_bytes();
+  if (_allocation_sample_bytes != 0 &&
+      (julong) allocated_before / _allocation_sample_bytes == allocated_after / _allocation_sample_bytes) {
+    return;
+  }
+  AllocTracer::send_allocation_in_new_tlab(klass, (HeapWord*) obj, remaining_after + alloc_size, alloc_size, thread);
+}
+
 /*
  * files with prints currently:
  * collectedHeap.inline.hpp, mmtkHeap.cpp,
@@ -36,29 +36,68 @@
 #include "gc/shared/workgroup.hpp"
 #include "memory/iterator.hpp"
 #include "memory/metaspace.hpp"
+#include "memory/referenceType.hpp"
 #include "mmtkCollectorPolicy.hpp"
 #include "mmtkFinalizerThread.hpp"
 #include "mmtkMemoryPool.hpp"
 #include "utilities/growableArray.hpp"
 #include "utilities/ostream.hpp"
+#include "utilities/ticks.hpp"
 
 class GCMemoryManager;
 class MemoryPool;
 //class mmtkGCTaskManager;
 class MMTkVMCompanionThread;
+struct MMTkMutatorContext;
 class MMTkHeap : public CollectedHeap {
   MMTkCollectorPolicy* _collector_policy;
   SoftRefPolicy _soft_ref_policy;
-  MMTkMemoryPool* _mmtk_pool;
-  GCMemoryManager* _mmtk_manager;
+  // One pool per MMTk space.
+  MMTkMemoryPool** _mmtk_pools;
+  size_t _num_mmtk_pools;
+  // Nursery pauses.  NULL if the plan is not generational.
+  GCMemoryManager* _nursery_manager;
+  // Full-heap pauses, or all pauses of a concurrent plan.
+  GCMemoryManager* _full_manager;
+  // Concurrent cycles, from the end of the pause that starts concurrent work to the end of the
+  // pause that finishes it.  NULL if the plan is not concurrent.
+  GCMemoryManager* _concurrent_manager;
+  // The manager of the ongoing pause.
+  GCMemoryManager* _pause_manager;
+  bool _in_concurrent_cycle;
+  // JFR event state.  Pauses are numbered from 0 and used as GC ids.
+  uint _gc_id;
+  Ticks _pause_start;
+  volatile size_t _enqueued_references[REF_PHANTOM + 1];
+  // References enqueued during a direct_stw pause, linked through their discovered fields, and the
+  // last one of them.  See swap_pending_references.
+  oop _pending_references;
+  oop _pending_references_tail;
   HeapWord* _start;
   HeapWord* _end;
   static MMTkHeap* _heap;
+  // Bytes a thread allocates between two sampled ObjectAllocationInNewTLAB events.  0 reports
+  // every bump region refill.
+  static size_t _allocation_sample_bytes;
   size_t _n_workers;
+#ifndef LINUX
+  // Mutators blocked for GC wait on this monitor.  On Linux they wait on a futex instead.
   Monitor* _gc_lock;
+#endif
   ContiguousSpace* _space;
   int _num_root_scan_tasks;
   MMTkVMCompanionThread* _companion_thread;
+  // Shared by all the string table scanning packets of a GC so that each of them claims a
+  // disjoint set of blocks from StringTable::weak_storage().
+  OopStorage::ParState<false /* concurrent */, false /* const */>* _string_table_par_state;
+  // The mutators of all Java threads, taken when the mutators stop and shared with MMTk for the
+  // rest of the pause.  The array is kept across GCs and only grows.
+  MMTkMutatorContext** _mutators;
+  size_t _num_mutators;
+  size_t _mutators_capacity;
+  bool _mutators_valid;
+  // Heap occupancy at the end of the previous pause, for the soft reference policy.
+  size_t _used_after_last_gc;
 public:
 
   MMTkHeap(MMTkCollectorPolicy* policy);
@@ -77,6 +116,18 @@ public:
   virtual HeapWord* mem_allocate(size_t size, bool* gc_overhead_limit_was_exceeded);
   HeapWord* mem_allocate_nonmove(size_t size, bool* gc_overhead_limit_was_exceeded);
 
+  // Allocate as CollectedHeap does, and report sampled refills of MMTk's bump regions to JFR as
+  // ObjectAllocationInNewTLAB.  TLABs are disabled with MMTk, so MemAllocator reports every
+  // allocation that reaches it as ObjectAllocationOutsideTLAB.
+  oop obj_allocate(Klass* klass, int size, TRAPS);
+  oop array_allocate(Klass* klass, int size, int length, bool do_zero, TRAPS);
+  oop class_allocate(Klass* klass, int size, TRAPS);
+
+private:
+  void sample_allocation(Thread* thread, Klass* klass, oop obj, int size, size_t remaining_before, jlong allocated_before);
+
+public:
+
   MMTkVMCompanionThread* companion_thread() const {
     return _companion_thread;
   }
@@ -114,9 +165,11 @@ public:
     _n_workers += 1;
   }
 
+#ifndef LINUX
   Monitor* gc_lock() {
     return _gc_lock;
   }
+#endif
 
   bool can_elide_tlab_store_barriers() const;
 
@@ -197,7 +250,58 @@ public:
 
   void scan_roots(OopClosure& cl);
 
-  void scan_roots_in_all_mutator_threads(OopClosure& cl);
+  // Set up and tear down the claiming state used by root scanning packets that split a root
+  // set between several GC workers. Must be called while the world is stopped.
+  void prepare_parallel_root_scanning();
+  void finish_parallel_root_scanning();
+
+  // Record the mutators of all Java threads once the world has stopped.  MMTk iterates over the
+  // snapshot to prepare, release and scan the mutators instead of walking the thread list again.
+  void snapshot_mutators();
+  void invalidate_mutators() { _mutators_valid = false; }
+  MMTkMutatorContext** mutators() const {
+    assert(_mutators_valid, "no mutator snapshot outside a pause");
+    return _mutators;
+  }
+  size_t num_mutators() const {
+    assert(_mutators_valid, "no mutator snapshot outside a pause");
+    return _num_mutators;
+  }
+  bool has_mutator_snapshot() const { return _mutators_valid; }
+
+  // Flush the allocation regions and barrier buffers of the running mutators through thread-local
+  // handshakes, so that each thread is paused on its own rather than at a global safepoint.  Must
+  // not be called by the VM thread, or by a GC thread while it has the world stopped.
+  void flush_mutators();
+
+  // Tell MMTk which soft references to clear in this GC, following the LRU policy of
+  // SoftRefLRUPolicyMSPerMB: the more free heap, the longer an unused soft reference survives.
+  void prepare_soft_reference_policy();
+  // Advance SoftReference.clock and record the heap occupancy once the GC is done.
+  void update_soft_reference_clock();
+
+  // Report the start and end of a pause to the GarbageCollectorMXBeans.  Called by the MMTk
+  // coordinator while the mutators are stopped.
+  // Also sends the GarbageCollection, GCPhasePause and GCReferenceStatistics JFR events of the
+  // pause.  `pause_start` is when the mutators were asked to stop.
+  void report_pause_begin(const Ticks& pause_start);
+  void report_pause_end();
+
+  // Send a GCPhasePauseLevel1 JFR event for a phase of the current pause.  May be called by any
+  // GC worker.
+  void send_phase_event(const char* name, const Ticks& start, const Ticks& end);
+  // Count references added to the pending list in the current pause, by reference type.  May be
+  // called by any GC worker.
+  void record_enqueued_references(const size_t* counts);
+  // With MMTkVMCompanionThread::direct_stw, no thread holds Heap_lock across the pause, and a GC
+  // worker cannot take it while the world is stopped without risking a deadlock with a Java
+  // thread that is stopped while holding it.  GC workers splice their references into a list of
+  // the heap instead, like Universe::swap_reference_pending_list, and the GC thread that resumes
+  // the mutators moves that list to the reference pending list with
+  // publish_pending_references.  May be called by any GC worker.
+  oop swap_pending_references(oop first, oop last);
+  // Must be called with Heap_lock held, after the world has resumed.
+  void publish_pending_references();
 
   void scan_universe_roots(OopClosure& cl);
   void scan_jni_handle_roots(OopClosure& cl);
@@ -208,7 +312,7 @@ public:
   void scan_system_dictionary_roots(OopClosure& cl);
   void scan_code_cache_roots(OopClosure& cl);
   void scan_string_table_roots(OopClosure& cl);
-  void scan_class_loader_data_graph_roots(OopClosure& cl);
+  void scan_class_loader_data_graph_roots(OopClosure& cl, bool scan_all);
   void scan_weak_processor_roots(OopClosure& cl);
   void scan_vm_thread_roots(OopClosure& cl);
 
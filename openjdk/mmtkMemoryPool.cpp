@@ -23,21 +23,33 @@
  */
 
 #include "precompiled.hpp"
+#include "mmtk.h"
 #include "mmtkMemoryPool.hpp"
 
-MMTkMemoryPool::MMTkMemoryPool(HeapWord* start, HeapWord* end,
-                               const char* name, size_t init_size,
+MMTkMemoryPool::MMTkMemoryPool(size_t space_index, const char* name, size_t max_size,
                                bool support_usage_threshold) :
-  CollectedMemoryPool(name, init_size,
-                      pointer_delta(start, end)*HeapWordSize, support_usage_threshold),
-            
-        _start(start), _end(end), _used_in_bytes(0){
+  CollectedMemoryPool(name, 0, max_size, support_usage_threshold),
+  _space_index(space_index) {
+}
+
+size_t MMTkMemoryPool::used_in_bytes() {
+  size_t used = 0, committed = 0;
+  mmtk_get_space_usage(_space_index, &used, &committed);
+  return used;
+}
+
+size_t MMTkMemoryPool::committed_in_bytes() {
+  size_t used = 0, committed = 0;
+  mmtk_get_space_usage(_space_index, &used, &committed);
+  return committed;
 }
 
 MemoryUsage MMTkMemoryPool::get_memory_usage() {
-  size_t maxSize   = (available_for_allocation() ? max_size() : 0);
-  size_t used      = used_in_bytes();
-  size_t committed = pointer_delta(_start, _end)*HeapWordSize;
+  size_t used = 0, committed = 0;
+  mmtk_get_space_usage(_space_index, &used, &committed);
+  // Both numbers are read without synchronizing with allocators.  Keep them consistent.
+  committed = MAX2(used, committed);
+  size_t maxSize = (available_for_allocation() ? max_size() : 0);
 
   return MemoryUsage(initial_size(), used, committed, maxSize);
 }
@@ -28,18 +28,18 @@
 #include "services/memoryPool.hpp"
 #include "services/memoryUsage.hpp"
 
+// A memory pool for one MMTk space.  Usage is read from MMTk's page accounting of the space.
 class MMTkMemoryPool : public CollectedMemoryPool {
 private:
-  HeapWord* _start;
-  HeapWord* _end;
-  size_t _used_in_bytes;
+  // Index of the space in mmtk_get_space_count()/mmtk_get_space_usage().
+  size_t _space_index;
 
 public:
-  MMTkMemoryPool(HeapWord* start, HeapWord* end, const char* name, size_t init_size,  bool support_usage_threshold);
+  MMTkMemoryPool(size_t space_index, const char* name, size_t max_size, bool support_usage_threshold);
 
   MemoryUsage get_memory_usage();
-  size_t used_in_bytes() { return _used_in_bytes; }
-  size_t max_size() const { return pointer_delta(_start, _end)*HeapWordSize; }
+  size_t used_in_bytes();
+  size_t committed_in_bytes();
 };
 
 
@@ -2,6 +2,7 @@
 #include "precompiled.hpp"
 #include "mmtk.h"
 #include "mmtkMutator.hpp"
+#include "runtime/thread.hpp"
 
 size_t MMTkMutatorContext::max_non_los_default_alloc_bytes = 0;
 
@@ -10,7 +11,11 @@ MMTkMutatorContext MMTkMutatorContext::bind(::Thread* current) {
     printf("ERROR: Unmatched free list allocator size: rs=%zu cpp=%zu\n", FREE_LIST_ALLOCATOR_SIZE, sizeof(FreeListAllocator));
     guarantee(false, "ERROR");
   }
-  return *((MMTkMutatorContext*) ::bind_mutator((void*) current));
+  MMTkMutatorContext context;
+  // mmtk-core only knows about the fields up to `fastpath_charged_bytes`.
+  memcpy(&context, ::bind_mutator((void*) current), offset_of(MMTkMutatorContext, fastpath_charged_bytes));
+  context.fastpath_charged_bytes = 0;
+  return context;
 }
 
 bool MMTkMutatorContext::is_ready_to_bind() {
@@ -25,16 +30,54 @@ HeapWord* MMTkMutatorContext::alloc(size_t bytes, Allocator allocator) {
     allocator = AllocatorLos;
   }
 
+  fastpath_charged_bytes = fastpath_bytes_remaining();
   // FIXME: Proper use of slow-path api
   HeapWord* o = (HeapWord*) ::alloc((MMTk_Mutator) this, bytes, HeapWordSize, 0, allocator);
   // Post allocation hooks. Note that we can get a nullptr from mmtk core in the case of OOM.
   // Hence, only call post allocation hooks if we have a proper object.
   if (o != nullptr) {
     ::post_alloc((MMTk_Mutator) this, o, bytes, allocator);
+    // The unused part of the old region was charged when the region was handed out.  Refund it,
+    // and charge the whole new region instead.  The object itself is charged by our caller,
+    // MemAllocator::allocate_outside_tlab, so if it was bump-allocated from the old region, this
+    // refunds it again.  If the slow path blocked for a GC, the GC has already swapped the old
+    // region for the one the thread resumed with.
+    size_t remaining_after = fastpath_bytes_remaining();
+    ((Thread*) mutator_tls)->incr_allocated_bytes((jlong) remaining_after - (jlong) fastpath_charged_bytes);
+    fastpath_charged_bytes = remaining_after;
   }
   return o;
 }
 
+size_t MMTkMutatorContext::fastpath_bytes_remaining() {
+  AllocatorSelector selector = get_allocator_mapping(AllocatorDefault);
+  void* cursor;
+  void* limit;
+  if (selector.tag == TAG_IMMIX) {
+    cursor = allocators.immix[selector.index].cursor;
+    limit = allocators.immix[selector.index].limit;
+  } else if (selector.tag == TAG_BUMP_POINTER) {
+    cursor = allocators.bump_pointer[selector.index].cursor;
+    limit = allocators.bump_pointer[selector.index].limit;
+  } else if (selector.tag == TAG_MARK_COMPACT) {
+    cursor = allocators.markcompact[selector.index].bump_allocator.cursor;
+    limit = allocators.markcompact[selector.index].bump_allocator.limit;
+  } else {
+    return 0;
+  }
+  return cursor < limit ? pointer_delta(limit, cursor, 1) : 0;
+}
+
+void MMTkMutatorContext::refund_fastpath_bytes() {
+  ((Thread*) mutator_tls)->incr_allocated_bytes(-(jlong) fastpath_bytes_remaining());
+  fastpath_charged_bytes = 0;
+}
+
+void MMTkMutatorContext::charge_fastpath_bytes() {
+  fastpath_charged_bytes = fastpath_bytes_remaining();
+  ((Thread*) mutator_tls)->incr_allocated_bytes((jlong) fastpath_charged_bytes);
+}
+
 void MMTkMutatorContext::flush() {
   ::flush_mutator((MMTk_Mutator) this);
 }
@@ -111,9 +111,24 @@ struct MMTkMutatorContext {
   void* mutator_tls;
   RustDynPtr plan;
   MutatorConfig config;
+  // Fields above mirror mmtk-core's `Mutator`.  Fields below are only used by the binding.
+
+  // The part of the bump region that the thread's allocated_bytes was last charged for.  The slow
+  // path charges against this rather than against the region it saw on entry, because a GC in
+  // the slow path refunds and recharges the region behind its back.
+  size_t fastpath_charged_bytes;
 
   HeapWord* alloc(size_t bytes, Allocator allocator = AllocatorDefault);
 
+  // The bytes left in the bump region that the allocation fast paths allocate into.  The thread's
+  // allocated_bytes is charged for the whole region when it is handed out, so that the fast
+  // paths do not need to update it.  Returns 0 if the default allocator has no such region.
+  size_t fastpath_bytes_remaining();
+  // Refund the unused part of the bump region before the GC or a flush may retire it, and charge
+  // the thread again for the region it is left with afterwards.
+  void refund_fastpath_bytes();
+  void charge_fastpath_bytes();
+
   void flush();
   void destroy();
 
@@ -12,16 +12,21 @@ class MMTkRootsClosure : public OopClosure {
   void** _buffer;
   size_t _cap;
   size_t _cursor;
+  // Bit 63 if compressed oops are enabled, so that Rust can tell full-width slots apart from
+  // narrow slots, or 0 otherwise. Computed once so that the tag is a plain OR for every slot.
+  const uintptr_t _wide_slot_tag;
 
   template <class T>
-  void do_oop_work(T* p, bool narrow) {
+  inline uintptr_t tag_of(T* p) const {
+    return sizeof(T) == sizeof(narrowOop) ? 0 : _wide_slot_tag;
+  }
+
+  template <class T>
+  void do_oop_work(T* p) {
     T heap_oop = RawAccess<>::oop_load(p);
     if (!CompressedOops::is_null(heap_oop)) {
-      if (UseCompressedOops && !narrow) {
-        guarantee((uintptr_t(p) & (1ull << 63)) == 0, "test");
-        p = (T*) (uintptr_t(p) | (1ull << 63));
-      }
-      _buffer[_cursor++] = (void*) p;
+      guarantee((uintptr_t(p) & (1ull << 63)) == 0, "slot address must not use the tag bit");
+      _buffer[_cursor++] = (void*) (uintptr_t(p) | tag_of(p));
       if (_cursor >= _cap) {
         flush();
       }
@@ -38,7 +43,11 @@ class MMTkRootsClosure : public OopClosure {
   }
 
 public:
-  MMTkRootsClosure(SlotsClosure slots_closure): _slots_closure(slots_closure), _cursor(0) {
+  MMTkRootsClosure(SlotsClosure slots_closure):
+    _slots_closure(slots_closure),
+    _cursor(0),
+    _wide_slot_tag(UseCompressedOops ? (1ull << 63) : 0)
+  {
     NewBuffer buf = slots_closure.invoke(NULL, 0, 0);
     _buffer = buf.buf;
     _cap = buf.cap;
@@ -51,8 +60,8 @@ public:
     }
   }
 
-  virtual void do_oop(oop* p)       { do_oop_work(p, false); }
-  virtual void do_oop(narrowOop* p) { do_oop_work(p, true); }
+  virtual void do_oop(oop* p)       { do_oop_work(p); }
+  virtual void do_oop(narrowOop* p) { do_oop_work(p); }
 };
 
 class MMTkScanObjectClosure : public BasicOopIterateClosure {
@@ -32,19 +32,33 @@
 #include "mmtkRootsClosure.hpp"
 #include "mmtkUpcalls.hpp"
 #include "mmtkVMCompanionThread.hpp"
+#include "oops/instanceKlass.hpp"
 #include "runtime/atomic.hpp"
 #include "runtime/mutexLocker.hpp"
+#include "runtime/orderAccess.hpp"
 #include "runtime/os.hpp"
 #include "runtime/safepoint.hpp"
 #include "runtime/thread.hpp"
 #include "runtime/threadSMR.hpp"
 #include "runtime/vmThread.hpp"
 #include "utilities/debug.hpp"
+#ifdef LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
 
 // Note: This counter must be accessed using the Atomic class.
 static volatile size_t mmtk_start_the_world_count = 0;
 
-static void mmtk_stop_all_mutators(void *tls, MutatorClosure closure) {
+#ifdef LINUX
+// The low 32 bits of mmtk_start_the_world_count, updated after the counter.  Mutators blocked in
+// mmtk_block_for_gc wait on this word with futex instead of on gc_lock, so that waking them does
+// not make all of them contend for one monitor right after a GC.
+static volatile int mmtk_start_the_world_futex = 0;
+#endif
+
+static void mmtk_stop_all_mutators(void *tls) {
+  Ticks pause_start = Ticks::now();
   ClassLoaderDataGraph::clear_claimed_marks();
   CodeCache::gc_prologue();
 #if COMPILER2_OR_JVMCI
@@ -55,16 +69,33 @@ static void mmtk_stop_all_mutators(void *tls, MutatorClosure closure) {
   MMTkHeap::heap()->companion_thread()->request(MMTkVMCompanionThread::_threads_suspended, true);
   log_debug(gc)("Mutators stopped. Now enumerate threads for scanning...");
 
-  JavaThreadIteratorWithHandle jtiwh;
-  while (JavaThread *cur = jtiwh.next()) {
-    closure.invoke((void*)&cur->third_party_heap_mutator);
+  MMTkHeap::heap()->prepare_parallel_root_scanning();
+  MMTkHeap::heap()->prepare_soft_reference_policy();
+  MMTkHeap::heap()->report_pause_begin(pause_start);
+
+  // MMTk visits the mutators in the snapshot once this returns, and keeps using it for the rest of
+  // the pause.
+  MMTkHeap::heap()->snapshot_mutators();
+  MMTkMutatorContext** mutators = MMTkHeap::heap()->mutators();
+  for (size_t i = 0; i < MMTkHeap::heap()->num_mutators(); i++) {
+    // The GC may reset the bump region, so refund the part of it that the thread has not used.
+    // mmtk_resume_mutators charges the thread again for whatever region it resumes with.
+    mutators[i]->refund_fastpath_bytes();
   }
 
-  log_debug(gc)("Finished enumerating threads.");
+  log_debug(gc)("Finished enumerating %zu threads.", MMTkHeap::heap()->num_mutators());
   nmethod::oops_do_marking_prologue();
 }
 
 static void mmtk_resume_mutators(void *tls) {
+  MMTkHeap::heap()->finish_parallel_root_scanning();
+  MMTkHeap::heap()->update_soft_reference_clock();
+  MMTkHeap::heap()->report_pause_end();
+  MMTkMutatorContext** mutators = MMTkHeap::heap()->mutators();
+  for (size_t i = 0; i < MMTkHeap::heap()->num_mutators(); i++) {
+    mutators[i]->charge_fastpath_bytes();
+  }
+  MMTkHeap::heap()->invalidate_mutators();
   nmethod::oops_do_marking_epilogue();
   // ClassLoaderDataGraph::purge();
   CodeCache::gc_epilogue();
@@ -83,10 +114,15 @@ static void mmtk_resume_mutators(void *tls) {
   MMTkHeap::heap()->companion_thread()->request(MMTkVMCompanionThread::_threads_resumed, true);
 
   log_debug(gc)("Notifying mutators blocking on the start-the-world counter...");
+#ifdef LINUX
+  OrderAccess::release_store(&mmtk_start_the_world_futex, (int) Atomic::load(&mmtk_start_the_world_count));
+  syscall(SYS_futex, &mmtk_start_the_world_futex, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
   {
     MutexLockerEx locker(MMTkHeap::heap()->gc_lock(), Mutex::_no_safepoint_check_flag);
     MMTkHeap::heap()->gc_lock()->notify_all();
   }
+#endif
 }
 
 static const int GC_THREAD_KIND_WORKER = 1;
@@ -132,6 +168,19 @@ static void mmtk_block_for_gc() {
     JavaThread* thread = JavaThread::current();
     ThreadBlockInVM tbivm(thread);
 
+#ifdef LINUX
+    for (;;) {
+      // Read the futex word before the counter.  If the counter is incremented after we read it,
+      // the futex word has changed, too, and FUTEX_WAIT returns immediately.
+      int futex_word = OrderAccess::load_acquire(&mmtk_start_the_world_futex);
+      if (Atomic::load(&mmtk_start_the_world_count) >= next_count) {
+        break;
+      }
+      // FUTEX_WAIT may return early (EAGAIN, EINTR or spuriously), but the authoritative
+      // condition for unblocking is mmtk_start_the_world_count being incremented.
+      syscall(SYS_futex, &mmtk_start_the_world_futex, FUTEX_WAIT_PRIVATE, futex_word, NULL, NULL, 0);
+    }
+#else
     // No safepoint check.  We are already in safepoint.
     MutexLockerEx locker(MMTkHeap::heap()->gc_lock(), Mutex::_no_safepoint_check_flag);
 
@@ -140,6 +189,7 @@ static void mmtk_block_for_gc() {
       // mmtk_start_the_world_count being incremented.
       MMTkHeap::heap()->gc_lock()->wait(Mutex::_no_safepoint_check_flag);
     }
+#endif
   }
   log_debug(gc)("Resumed after GC finished.");
 }
@@ -172,21 +222,33 @@ static bool mmtk_is_mutator(void* tls) {
   return ((Thread*) tls)->third_party_heap_collector == NULL;
 }
 
-static void mmtk_get_mutators(MutatorClosure closure) {
+// The mutators recorded by mmtk_stop_all_mutators.  Only valid until the mutators resume.
+// Returns NULL outside a pause.
+static MMTk_Mutator* mmtk_get_mutators(size_t* len) {
+  if (!MMTkHeap::heap()->has_mutator_snapshot()) {
+    *len = 0;
+    return NULL;
+  }
+  *len = MMTkHeap::heap()->num_mutators();
+  return (MMTk_Mutator*) MMTkHeap::heap()->mutators();
+}
+
+// Outside a pause, threads may start and exit at any time, so walk the thread list instead of
+// using a snapshot.
+static void mmtk_get_live_mutators(MutatorClosure closure) {
   JavaThread *thr;
   for (JavaThreadIteratorWithHandle jtiwh; (thr = jtiwh.next());) {
     closure.invoke(&thr->third_party_heap_mutator);
   }
 }
 
-static void mmtk_scan_roots_in_all_mutator_threads(SlotsClosure closure) {
-  MMTkRootsClosure cl(closure);
-  MMTkHeap::heap()->scan_roots_in_all_mutator_threads(cl);
-}
-
+// Called once per mutator from a `ScanMutatorRoots` packet, so Java stacks are
+// scanned in parallel by all the GC workers rather than by one worker walking
+// every thread.
 static void mmtk_scan_roots_in_mutator_thread(SlotsClosure closure, void* tls) {
   ResourceMark rm;
   JavaThread* thread = (JavaThread*) tls;
+  assert(thread->is_Java_thread(), "only Java threads have mutator roots");
   MMTkRootsClosure cl(closure);
   thread->oops_do(&cl, NULL);
 }
@@ -255,6 +317,10 @@ static int discovered_offset() {
   return java_lang_ref_Reference::discovered_offset;
 }
 
+static int soft_reference_timestamp_offset() {
+  return java_lang_ref_SoftReference::timestamp_offset;
+}
+
 static char* dump_object_string(void* object) {
   oop o = (oop) object;
   return o->print_value_string();
@@ -264,20 +330,34 @@ static void mmtk_schedule_finalizer() {
   MMTkHeap::heap()->schedule_finalizer();
 }
 
-static void mmtk_scan_universe_roots(SlotsClosure closure) { MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_universe_roots(cl); }
-static void mmtk_scan_jni_handle_roots(SlotsClosure closure) { MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_jni_handle_roots(cl); }
-static void mmtk_scan_object_synchronizer_roots(SlotsClosure closure) { MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_object_synchronizer_roots(cl); }
-static void mmtk_scan_management_roots(SlotsClosure closure) { MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_management_roots(cl); }
-static void mmtk_scan_jvmti_export_roots(SlotsClosure closure) { MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_jvmti_export_roots(cl); }
-static void mmtk_scan_aot_loader_roots(SlotsClosure closure) { MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_aot_loader_roots(cl); }
-static void mmtk_scan_system_dictionary_roots(SlotsClosure closure) { MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_system_dictionary_roots(cl); }
-static void mmtk_scan_code_cache_roots(SlotsClosure closure) { MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_code_cache_roots(cl); }
-static void mmtk_scan_string_table_roots(SlotsClosure closure) { MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_string_table_roots(cl); }
-static void mmtk_scan_class_loader_data_graph_roots(SlotsClosure closure) { MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_class_loader_data_graph_roots(cl); }
-static void mmtk_scan_weak_processor_roots(SlotsClosure closure) { MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_weak_processor_roots(cl); }
-static void mmtk_scan_vm_thread_roots(SlotsClosure closure) { MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_vm_thread_roots(cl); }
+// Reports the enclosing scope as a phase of the current pause to JFR.
+class MMTkPhaseEvent : public StackObj {
+  const char* _name;
+  Ticks _start;
+public:
+  MMTkPhaseEvent(const char* name) : _name(name), _start(Ticks::now()) {}
+  ~MMTkPhaseEvent() { MMTkHeap::heap()->send_phase_event(_name, _start, Ticks::now()); }
+};
+
+static void mmtk_scan_universe_roots(SlotsClosure closure) { MMTkPhaseEvent e("Scan Universe Roots"); MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_universe_roots(cl); }
+static void mmtk_scan_jni_handle_roots(SlotsClosure closure) { MMTkPhaseEvent e("Scan JNI Handle Roots"); MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_jni_handle_roots(cl); }
+static void mmtk_scan_object_synchronizer_roots(SlotsClosure closure) { MMTkPhaseEvent e("Scan Object Synchronizer Roots"); MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_object_synchronizer_roots(cl); }
+static void mmtk_scan_management_roots(SlotsClosure closure) { MMTkPhaseEvent e("Scan Management Roots"); MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_management_roots(cl); }
+static void mmtk_scan_jvmti_export_roots(SlotsClosure closure) { MMTkPhaseEvent e("Scan JVMTI Export Roots"); MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_jvmti_export_roots(cl); }
+static void mmtk_scan_aot_loader_roots(SlotsClosure closure) { MMTkPhaseEvent e("Scan AOT Loader Roots"); MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_aot_loader_roots(cl); }
+static void mmtk_scan_system_dictionary_roots(SlotsClosure closure) { MMTkPhaseEvent e("Scan System Dictionary Roots"); MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_system_dictionary_roots(cl); }
+static void mmtk_scan_code_cache_roots(SlotsClosure closure) { MMTkPhaseEvent e("Scan Code Cache Roots"); MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_code_cache_roots(cl); }
+static void mmtk_scan_string_table_roots(SlotsClosure closure) { MMTkPhaseEvent e("Scan String Table Roots"); MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_string_table_roots(cl); }
+static void mmtk_scan_class_loader_data_graph_roots(SlotsClosure closure, bool scan_all) { MMTkPhaseEvent e("Scan Class Loader Data Graph Roots"); MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_class_loader_data_graph_roots(cl, scan_all); }
+static void mmtk_scan_weak_processor_roots(SlotsClosure closure) { MMTkPhaseEvent e("Scan Weak Processor Roots"); MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_weak_processor_roots(cl); }
+static void mmtk_scan_vm_thread_roots(SlotsClosure closure) { MMTkPhaseEvent e("Scan VM Thread Roots"); MMTkRootsClosure cl(closure); MMTkHeap::heap()->scan_vm_thread_roots(cl); }
 
 static size_t mmtk_number_of_mutators() {
+  // Must agree with the snapshot MMTk iterates over during a pause, as MMTk counts scanned
+  // mutators against this number.
+  if (MMTkHeap::heap()->has_mutator_snapshot()) {
+    return MMTkHeap::heap()->num_mutators();
+  }
   return Threads::number_of_threads();
 }
 
@@ -286,15 +366,22 @@ static void mmtk_prepare_for_roots_re_scanning() {
   DerivedPointerTable::update_pointers();
   DerivedPointerTable::clear();
 #endif
+  // Blocks claimed in the previous scan must be claimable again.
+  MMTkHeap::heap()->prepare_parallel_root_scanning();
 }
 
+// Link `objects` into a list and splice it onto the reference pending list. GC workers may call
+// this concurrently for disjoint sets of references; the splice is a single atomic swap.
 static void mmtk_enqueue_references(void** objects, size_t len) {
   if (len == 0) {
     return;
   }
+  MMTkPhaseEvent e("Enqueue References");
 
   oop first = (oop) objects[0]; // This points to the first node of the linked list.
   oop last = first; // This points to the last node of the linked list.
+  size_t counts[REF_PHANTOM + 1] = {0};
+  counts[InstanceKlass::cast(first->klass())->reference_type()]++;
 
   for (size_t i = 1; i < len; i++) {
     oop reff = (oop) objects[i];
@@ -321,9 +408,16 @@ static void mmtk_enqueue_references(void** objects, size_t len) {
     }
     HeapAccess<AS_RAW>::oop_store_at(last, java_lang_ref_Reference::discovered_offset, reff);
     last = reff;
+    counts[InstanceKlass::cast(reff->klass())->reference_type()]++;
   }
-
-  oop old_first = Universe::swap_reference_pending_list(first);
+  MMTkHeap::heap()->record_enqueued_references(counts);
+
+  // Another worker may splice its list in between these two steps, but the world is stopped, so
+  // no one walks the pending list before all of them are done.  With direct_stw, no thread holds
+  // Heap_lock for this pause, so the list goes to the heap until the world resumes.
+  oop old_first = MMTkVMCompanionThread::direct_stw
+      ? MMTkHeap::heap()->swap_pending_references(first, last)
+      : Universe::swap_reference_pending_list(first);
   HeapAccess<AS_RAW>::oop_store_at(last, java_lang_ref_Reference::discovered_offset, old_first);
 }
 
@@ -334,6 +428,7 @@ OpenJDK_Upcalls mmtk_upcalls = {
   mmtk_block_for_gc,
   mmtk_out_of_memory,
   mmtk_get_mutators,
+  mmtk_get_live_mutators,
   mmtk_scan_object,
   mmtk_dump_object,
   mmtk_get_object_size,
@@ -346,8 +441,8 @@ OpenJDK_Upcalls mmtk_upcalls = {
   static_oop_field_count_offset,
   referent_offset,
   discovered_offset,
+  soft_reference_timestamp_offset,
   dump_object_string,
-  mmtk_scan_roots_in_all_mutator_threads,
   mmtk_scan_roots_in_mutator_thread,
   mmtk_scan_universe_roots,
   mmtk_scan_jni_handle_roots,
@@ -24,10 +24,16 @@
 
 #include "precompiled.hpp"
 #include "mmtk.h"
+#include "mmtkHeap.hpp"
 #include "mmtkVMCompanionThread.hpp"
+#include "memory/universe.hpp"
 #include "runtime/mutex.hpp"
+#include "runtime/mutexLocker.hpp"
 #include "logging/log.hpp"
 
+bool MMTkVMCompanionThread::direct_stw = false;
+size_t MMTkVMCompanionThread::flush_mutators_interval_ms = 0;
+
 MMTkVMCompanionThread::MMTkVMCompanionThread():
     NamedThread(),
     _desired_state(_threads_resumed),
@@ -49,13 +55,12 @@ void MMTkVMCompanionThread::run() {
   for (;;) {
     // Wait for suspend request
     log_trace(gc)("MMTkVMCompanionThread: Waiting for suspend request...");
-    {
-      MutexLockerEx locker(_lock, Mutex::_no_safepoint_check_flag);
-      assert(_reached_state == _threads_resumed, "Threads should be running at this moment.");
-      while (_desired_state != _threads_suspended) {
-        _lock->wait(Mutex::_no_safepoint_check_flag);
-      }
-      assert(_reached_state == _threads_resumed, "Threads should still be running at this moment.");
+    if (!wait_for_suspend_request()) {
+      // The handshakes are queued behind any stop-the-world operation a GC thread requests
+      // meanwhile, and are done once the world runs again.
+      log_trace(gc)("MMTkVMCompanionThread: Flushing mutators...");
+      MMTkHeap::heap()->flush_mutators();
+      continue;
     }
 
     // Let the VM thread stop the world.
@@ -69,6 +74,27 @@ void MMTkVMCompanionThread::run() {
   }
 }
 
+bool MMTkVMCompanionThread::wait_for_suspend_request() {
+  MutexLockerEx locker(_lock, Mutex::_no_safepoint_check_flag);
+  assert(direct_stw || _reached_state == _threads_resumed, "Threads should be running at this moment.");
+  // With direct_stw, a GC thread handles stop-the-world requests itself.
+  while (direct_stw || _desired_state != _threads_suspended) {
+    // Set while the mutators run between the pauses of a concurrent GC.  Setting or clearing it is
+    // followed by a start-the-world request, which wakes this thread up.
+    bool marking = CONCURRENT_MARKING_ACTIVE != 0 && _reached_state == _threads_resumed;
+    if (flush_mutators_interval_ms != 0 && marking) {
+      bool timed_out = _lock->wait(Mutex::_no_safepoint_check_flag, (long) flush_mutators_interval_ms);
+      if (timed_out && _desired_state == _threads_resumed && _reached_state == _threads_resumed) {
+        return false;
+      }
+    } else {
+      _lock->wait(Mutex::_no_safepoint_check_flag);
+    }
+  }
+  assert(_reached_state == _threads_resumed, "Threads should still be running at this moment.");
+  return true;
+}
+
 // Request stop-the-world or start-the-world.  This method is supposed to be
 // called by a GC thread.
 //
@@ -84,14 +110,34 @@ void MMTkVMCompanionThread::request(stw_state desired_state, bool wait_until_rea
   assert(Thread::current() != this, "Requests can only be made by GC threads. Found companion thread.");
   assert(!Thread::current()->is_Java_thread(), "Requests can only be made by GC threads. Found Java thread.");
 
-  MutexLockerEx locker(_lock, Mutex::_no_safepoint_check_flag);
-  assert(_desired_state != desired_state, "State %d already requested.", desired_state);
-  _desired_state = desired_state;
-  _lock->notify_all();
+  {
+    MutexLockerEx locker(_lock, Mutex::_no_safepoint_check_flag);
+    assert(_desired_state != desired_state, "State %d already requested.", desired_state);
+    _desired_state = desired_state;
+    mmtk_probe_stw_request(desired_state);
+    _lock->notify_all();
+  }
+
+  if (direct_stw && desired_state == _threads_suspended) {
+    // Enqueue the operation ourselves.  It is asynchronous, so this returns as soon as the
+    // operation is queued, and the VM thread deletes it after evaluating it.  This must not be
+    // done while holding _lock, which has the same rank as VMOperationQueue_lock.
+    VMThread::execute(new VM_MMTkSTWOperation(this, true /* async */));
+  }
 
   if (wait_until_reached) {
-    while (_reached_state != desired_state) {
-      _lock->wait(Mutex::_no_safepoint_check_flag);
+    wait_for_reached(desired_state);
+  }
+
+  if (direct_stw && desired_state == _threads_resumed) {
+    // The epilogue of an asynchronous operation is not run, so publish the references enqueued
+    // during the pause and notify the reference handler thread here instead of in
+    // VM_MMTkSTWOperation::doit_epilogue.  Java threads are running again, so whoever holds
+    // Heap_lock will release it.
+    MutexLockerEx ml(Heap_lock);
+    MMTkHeap::heap()->publish_pending_references();
+    if (Universe::has_reference_pending_list()) {
+      Heap_lock->notify_all();
     }
   }
 }
@@ -122,6 +168,7 @@ void MMTkVMCompanionThread::do_mmtk_stw_operation() {
 
     // Tell the waiter thread that Java threads have stopped at yieldpoints.
     _reached_state = _threads_suspended;
+    mmtk_probe_stw_reached(_threads_suspended);
     log_trace(gc)("do_mmtk_stw_operation: Reached _thread_suspended state. Notifying...");
     _lock->notify_all();
 
@@ -163,6 +210,7 @@ void MMTkVMCompanionThread::do_mmtk_stw_operation() {
     assert(_desired_state == _threads_resumed, "start-the-world should be requested.");
     assert(_reached_state == _threads_suspended, "Threads should still be suspended at this moment.");
     _reached_state = _threads_resumed;
+    mmtk_probe_stw_reached(_threads_resumed);
     log_trace(gc)("do_mmtk_stw_operation: Reached _thread_resumed state. Notifying...");
     _lock->notify_all();
   }
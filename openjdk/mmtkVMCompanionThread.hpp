@@ -40,6 +40,16 @@
 // the world, whthout blocking the callers.  This thread bridges the API gap
 // by calling VMThread::execute on behalf of GC threads upon reques so that it
 // blocks this thread instead of GC threads.
+//
+// With `direct_stw`, the GC thread that requests stop-the-world enqueues an
+// asynchronous VM_MMTkSTWOperation itself, which saves waking this thread before
+// the VM thread can start the safepoint.  The thread is then only started if it
+// has mutators to flush.
+//
+// With `flush_mutators_interval_ms`, this thread also flushes the mutators
+// through handshakes at that interval while a concurrent plan is marking, so
+// their barrier buffers reach MMTk while the world runs instead of all at the
+// pause that finishes marking.
 class MMTkVMCompanionThread: public NamedThread {
 public:
   enum stw_state {
@@ -51,7 +61,15 @@ private:
   stw_state _desired_state;
   stw_state _reached_state;
 
+  // Wait for a stop-the-world request.  Returns false instead if it is time to flush the mutators.
+  bool wait_for_suspend_request();
+
 public:
+  // Set from the MMTK_DIRECT_STW environment variable.
+  static bool direct_stw;
+  // Set from the MMTK_FLUSH_MUTATORS_INTERVAL_MS environment variable.  0 disables flushing.
+  static size_t flush_mutators_interval_ms;
+
   // Constructor
   MMTkVMCompanionThread();
   ~MMTkVMCompanionThread();
@@ -28,12 +28,17 @@
 #include "mmtkVMOperation.hpp"
 #include "logging/log.hpp"
 
-VM_MMTkSTWOperation::VM_MMTkSTWOperation(MMTkVMCompanionThread *companion_thread):
-    _companion_thread(companion_thread) {
+VM_MMTkSTWOperation::VM_MMTkSTWOperation(MMTkVMCompanionThread *companion_thread, bool async):
+    _companion_thread(companion_thread), _async(async) {
 }
 
 bool VM_MMTkSTWOperation::doit_prologue() {
-    Heap_lock->lock();
+    // The epilogue of an asynchronous operation is never run, so it cannot hold Heap_lock across
+    // the pause.  GC workers keep the references they enqueue in the heap instead, and
+    // MMTkVMCompanionThread::request moves them to the pending list under Heap_lock when resuming.
+    if (!_async) {
+        Heap_lock->lock();
+    }
     return true;
 }
 
@@ -36,9 +36,13 @@ class MMTkVMCompanionThread;
 class VM_MMTkSTWOperation : public VM_MMTkOperation {
 private:
   MMTkVMCompanionThread* _companion_thread;
+  // Enqueued by a GC thread without waiting for it (MMTkVMCompanionThread::direct_stw).
+  bool _async;
 
 public:
-  VM_MMTkSTWOperation(MMTkVMCompanionThread *companion_thread);
+  VM_MMTkSTWOperation(MMTkVMCompanionThread *companion_thread, bool async = false);
+  virtual Mode evaluation_mode() const override { return _async ? _async_safepoint : _safepoint; }
+  virtual bool is_cheap_allocated() const override { return _async; }
   virtual bool doit_prologue() override;
   virtual void doit() override;
   virtual void doit_epilogue() override;
@@ -1,5 +1,30 @@
 #!/usr/bin/env python3
 
+STW_STATES = ["suspend", "resume"]
+
+# Timestamp of the last `stw_request` of each state, for computing how long the VM took to reach
+# that state.
+last_stw_request_ts = {}
+
+def enrich_event_extra(log_processor, name, ph, tid, ts, result, args):
+    match name:
+        case "stw_request":
+            state = STW_STATES[int(args[0])]
+            last_stw_request_ts[state] = int(ts)
+            result["name"] = f"stw_request_{state}"
+            result.setdefault("args", {}).update({"state": state})
+        case "stw_reached":
+            state = STW_STATES[int(args[0])]
+            result["name"] = f"stw_reached_{state}"
+            extra = {"state": state}
+            request_ts = last_stw_request_ts.pop(state, None)
+            if request_ts is not None:
+                # For "suspend", this is the time-to-safepoint.
+                extra["time_to_reach_us"] = (int(ts) - request_ts) / 1000
+            result.setdefault("args", {}).update(extra)
+        case "finalizer_batch":
+            result.setdefault("args", {}).update({"objects": int(args[0])})
+
 def enrich_meta_extra(log_processor, name, tid, ts, gc, wp, args):
     if wp is not None:
         match name:
@@ -11,3 +36,13 @@ def enrich_meta_extra(log_processor, name, tid, ts, gc, wp, args):
                     "mature_slots": mature,
                     "total_slots": total,
                 }
+            case "roots":
+                category, slots = args[0], int(args[1])
+                wp["args"] |= {
+                    "root_category": category,
+                    "slots": slots,
+                }
+            case "enqueue_references":
+                wp["args"] |= {
+                    "references": int(args[0]),
+                }